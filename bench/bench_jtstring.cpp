@@ -0,0 +1,1013 @@
+#include "jtstring.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <compare>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+// Sizes covering the inline buffer (0-31), the SSO/heap boundary (29-32) and heap strings
+static constexpr std::size_t sizes[] = {0, 1, 8, 16, 29, 30, 31, 32, 64, 256, 4096};
+
+// Number of states each timed batch works on
+static constexpr std::size_t batch_size = 256;
+
+template<typename T>
+inline void do_not_optimize(T const & value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Heap allocations made by this thread, counted by the replacement operator new below
+static thread_local auto allocations = std::size_t{0};
+
+// The replacements are kept out of line: once inlined, GCC sees std::free() called on what it still treats as the
+// result of the builtin operator new and reports -Wmismatched-new-delete, although the pair is matched here
+[[gnu::noinline]] void * operator new(std::size_t size) {
+  allocations += 1;
+  if (auto const p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void * p) noexcept {
+  std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void * p, std::size_t) noexcept {
+  std::free(p);
+}
+
+template<typename S> constexpr auto type_name = "?"sv;
+template<> constexpr auto type_name<std::string> = "std::string"sv;
+template<> constexpr auto type_name<std::string_view> = "std::string_view"sv;
+template<> constexpr auto type_name<jtstring> = "jtstring"sv;
+template<> constexpr auto type_name<jtstring_malloc> = "jtstring_malloc"sv;
+template<> constexpr auto type_name<jtstring_pmr> = "jtstring_pmr"sv;
+template<> constexpr auto type_name<jtstring_cached> = "jtstring_cached"sv;
+template<> constexpr auto type_name<jtstring_pooled> = "jtstring_pooled"sv;
+template<> constexpr auto type_name<jtstring_shared> = "jtstring_shared"sv;
+template<> constexpr auto type_name<jtrope> = "jtrope"sv;
+template<> constexpr auto type_name<jtstring_inline<64>> = "jtstring_inline<64>"sv;
+template<> constexpr auto type_name<jtstring_inline<128>> = "jtstring_inline<128>"sv;
+template<> constexpr auto type_name<basic_jtstring<std::allocator<char>, jtstring_growth_one_and_half>> = "jtstring<1.5x>"sv;
+template<> constexpr auto type_name<basic_jtstring<std::allocator<char>, jtstring_growth_size_class>> = "jtstring<size class>"sv;
+
+struct bench_result {
+  std::string_view benchmark;
+  std::string_view type;
+  std::size_t size;
+  std::size_t iterations;
+  double ns_per_op;
+  double allocations_per_op;
+};
+
+struct bench_options {
+  std::string_view format = "csv";
+  std::string_view filter = "";
+  std::chrono::nanoseconds min_time = 20ms;
+};
+
+static auto options = bench_options{};
+static auto results = std::vector<bench_result>{};
+
+// Runs `op` over freshly `setup` batches until `min_time` has been spent inside `op`.
+// Only the calls to `op` are timed, so construction of the batch is not measured, and only their allocations counted.
+// `ops_per_call` reports the time per element for operations that repeat an operation internally
+template<typename Setup, typename Op>
+void measure(std::string_view benchmark, std::string_view type, std::size_t size, Setup setup, Op op, std::size_t batch_size = ::batch_size, std::size_t ops_per_call = 1) {
+  if (benchmark.find(options.filter) == std::string_view::npos) {
+    return;
+  }
+
+  auto elapsed = std::chrono::nanoseconds{0};
+  auto iterations = std::size_t{0};
+  auto allocated = std::size_t{0};
+  while (elapsed < options.min_time) {
+    auto batch = std::vector<decltype(setup())>{};
+    batch.reserve(batch_size);
+    for (auto i = std::size_t{0}; i < batch_size; i += 1) {
+      batch.push_back(setup());
+    }
+
+    auto const before = allocations;
+    auto const start = std::chrono::steady_clock::now();
+    for (auto & state : batch) {
+      op(state);
+      do_not_optimize(state);
+    }
+    elapsed += std::chrono::steady_clock::now() - start;
+    allocated += allocations - before;
+    iterations += batch_size;
+  }
+
+  results.push_back
+    ( { benchmark
+      , type
+      , size
+      , iterations
+      , static_cast<double>(elapsed.count()) / static_cast<double>(iterations * ops_per_call)
+      , static_cast<double>(allocated) / static_cast<double>(iterations * ops_per_call)
+      }
+    );
+}
+
+auto make_input(std::size_t size, char seed = 'a') -> std::string {
+  auto s = std::string(size, '\0');
+  for (auto i = std::size_t{0}; i < size; i += 1) {
+    s[i] = static_cast<char>(seed + i % 26);
+  }
+  return s;
+}
+
+template<typename S>
+void bench_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto const input = make_input(size);
+  auto const other = make_input(size, 'b');
+  auto const piece = make_input(8, 'A');
+  auto const view = std::string_view{input};
+
+  measure("construct(sv)", type, size, [&] { return view; }, [](std::string_view & v) {
+    auto s = S{v};
+    do_not_optimize(s);
+  });
+
+  measure("copy", type, size, [&] { return S{view}; }, [](S const & s) {
+    auto copy = S{s};
+    do_not_optimize(copy);
+  });
+
+  measure("move", type, size, [&] { return S{view}; }, [](S & s) {
+    auto moved = S{std::move(s)};
+    do_not_optimize(moved);
+  });
+
+  measure("append(sv)", type, size, [&] { return S{view}; }, [&](S & s) {
+    s.append(piece);
+  });
+
+  measure("push_back", type, size, [&] { return S{view}; }, [](S & s) {
+    s.push_back('x');
+  });
+
+  measure("insert(middle, sv)", type, size, [&] { return S{view}; }, [&](S & s) {
+    if constexpr (std::is_same_v<S, std::string>) {
+      s.insert(s.size() / 2, piece);
+    } else {
+      s.insert(s.begin() + s.size() / 2, piece);
+    }
+  });
+
+  // Non-const operator[] per character, which has to clear a cached hash and, when shared, detach
+  measure("operator[] write loop", type, size, [&] { return S{view}; }, [](S & s) {
+    for (auto i = std::size_t{0}; i < s.size(); i += 1) {
+      s[i] = static_cast<char>(s[i] ^ 0x20);
+    }
+  });
+
+  measure("replace(middle, 4, sv)", type, size, [&] { return S{view}; }, [&](S & s) {
+    s.replace(s.size() / 2, 4, piece);
+  });
+
+  measure("erase(front half)", type, size, [&] { return S{view}; }, [](S & s) {
+    s.erase(0, s.size() / 2);
+  });
+
+  measure("substr(1)", type, size, [&] { return S{view}; }, [](S const & s) {
+    auto sub = s.substr(s.empty() ? 0 : 1);
+    do_not_optimize(sub);
+  });
+
+  measure("operator+", type, size, [&] { return std::pair{S{view}, S{std::string_view{other}}}; }, [](auto const & p) {
+    auto sum = p.first + p.second;
+    do_not_optimize(sum);
+  });
+
+  measure("operator==(equal)", type, size, [&] { return std::pair{S{view}, S{view}}; }, [](auto const & p) {
+    auto eq = p.first == p.second;
+    do_not_optimize(eq);
+  });
+
+  auto last_differs = input;
+  if (size > 0) {
+    last_differs.back() = '#';
+  }
+
+  measure("operator==(last differs)", type, size, [&] { return std::pair{S{view}, S{std::string_view{last_differs}}}; }, [](auto const & p) {
+    auto eq = p.first == p.second;
+    do_not_optimize(eq);
+  });
+
+  measure("starts_with(sv)", type, size, [&] { return S{view}; }, [&](S const & s) {
+    auto found = s.starts_with(view.substr(0, size / 2 + 1));
+    do_not_optimize(found);
+  });
+
+  measure("ends_with(sv)", type, size, [&] { return S{view}; }, [&](S const & s) {
+    auto found = s.ends_with(view.substr(size / 2));
+    do_not_optimize(found);
+  });
+
+  measure("operator<=>", type, size, [&] { return std::pair{S{view}, S{std::string_view{other}}}; }, [](auto const & p) {
+    auto cmp = p.first <=> p.second;
+    do_not_optimize(cmp);
+  });
+}
+
+// Builds one multi-megabyte string per operation, dominated by reallocation bandwidth
+template<typename S>
+void bench_large_type() {
+  auto const type = type_name<S>;
+  auto const chunk = make_input(4096);
+  auto constexpr target = std::size_t{8} << 20;
+
+  measure("append(4 KiB) to 8 MiB", type, target, [] { return S{}; }, [&](S & s) {
+    while (s.size() < target) {
+      s.append(chunk);
+    }
+  }, 1);
+
+  measure("append(4 KiB) to 64 MiB", type, target * 8, [] { return S{}; }, [&](S & s) {
+    while (s.size() < target * 8) {
+      s.append(chunk);
+    }
+  }, 1);
+}
+
+// Grows a string one element at a time up to `size`, reporting the time per element,
+// which stays flat as `size` increases when growth is amortised O(1)
+template<typename S>
+void bench_growth_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto const batch = std::max(std::size_t{1}, (std::size_t{1} << 16) / size);
+
+  measure("grow by push_back", type, size, [] { return S{}; }, [=](S & s) {
+    for (auto i = std::size_t{0}; i < size; i += 1) {
+      s.push_back('x');
+    }
+  }, batch, size);
+
+  measure("grow by append(sv)", type, size, [] { return S{}; }, [=](S & s) {
+    for (auto i = std::size_t{0}; i < size; i += 1) {
+      s.append("x"sv);
+    }
+  }, batch, size);
+
+  measure("grow by append(1, ch)", type, size, [] { return S{}; }, [=](S & s) {
+    for (auto i = std::size_t{0}; i < size; i += 1) {
+      s.append(1, 'x');
+    }
+  }, batch, size);
+
+  measure("grow by insert(end, sv)", type, size, [] { return S{}; }, [=](S & s) {
+    for (auto i = std::size_t{0}; i < size; i += 1) {
+      if constexpr (std::is_same_v<S, std::string>) {
+        s.insert(s.size(), "x"sv);
+      } else {
+        s.insert(s.end(), "x"sv);
+      }
+    }
+  }, batch, size);
+
+  measure("grow by resize(size() + 1)", type, size, [] { return S{}; }, [=](S & s) {
+    for (auto i = std::size_t{0}; i < size; i += 1) {
+      s.resize(s.size() + 1, 'x');
+    }
+  }, batch, size);
+}
+
+// Searches that only match at the far end, so the whole haystack is scanned
+template<typename S>
+void bench_find_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto input = make_input(size);
+  input.back() = '#';
+  if (size >= 4) {
+    input.replace(size - 4, 4, "#$%&");
+  }
+  auto const haystack = S{std::string_view{input}};
+  auto const set = "#!?@"sv;
+
+  measure("find(ch)", type, size, [&] { return &haystack; }, [](S const * h) {
+    auto found = h->find('#');
+    do_not_optimize(found);
+  });
+
+  measure("rfind(ch)", type, size, [&] { return &haystack; }, [](S const * h) {
+    auto found = h->rfind('a');
+    do_not_optimize(found);
+  });
+
+  measure("find(sv)", type, size, [&] { return &haystack; }, [](S const * h) {
+    auto found = h->find("#$%&"sv);
+    do_not_optimize(found);
+  });
+
+  measure("find_first_of(4 chars)", type, size, [&] { return &haystack; }, [&](S const * h) {
+    auto found = h->find_first_of(set);
+    do_not_optimize(found);
+  });
+
+  measure("find_first_not_of(26 chars)", type, size, [&] { return &haystack; }, [](S const * h) {
+    auto found = h->find_first_not_of("abcdefghijklmnopqrstuvwxyz"sv);
+    do_not_optimize(found);
+  });
+}
+
+// Looks each probe up in a bucket of similar keys, the way a hash map compares keys within a bucket.
+// Keys share a prefix and differ near the end, as identifiers such as "user:session:000042" do.
+template<typename S>
+void bench_keys_type(std::size_t key_length) {
+  auto const type = type_name<S>;
+  auto constexpr bucket_size = std::size_t{8};
+
+  auto keys = std::vector<S>{};
+  for (auto i = std::size_t{0}; i < bucket_size; i += 1) {
+    auto key = make_input(key_length);
+    for (auto j = key_length, n = i; j > 0 && n > 0; j -= 1, n /= 10) {
+      key[j - 1] = static_cast<char>('0' + n % 10);
+    }
+    keys.push_back(S{std::string_view{key}});
+  }
+
+  auto probe = std::size_t{0};
+  measure("bucket lookup", type, key_length, [&] { return S{keys[probe++ % bucket_size]}; }, [&](S const & key) {
+    auto found = std::find(keys.begin(), keys.end(), key);
+    do_not_optimize(found);
+  });
+}
+
+void replace_all(std::string & s, std::string_view needle, std::string_view replacement) {
+  for (auto pos = s.find(needle); pos != std::string::npos; pos = s.find(needle, pos + replacement.size())) {
+    s.replace(pos, needle.size(), replacement);
+  }
+}
+
+void replace_all(jtstring & s, std::string_view needle, std::string_view replacement) {
+  s.replace_all(needle, replacement);
+}
+
+// Replaces every 26th character of a heap string with a shorter, equal and longer replacement
+template<typename S>
+void bench_map_type(std::size_t key_length) {
+  auto const type = type_name<S>;
+  auto constexpr key_count = std::size_t{1024};
+
+  auto keys = std::vector<S>{};
+  auto map = std::unordered_map<S, int>{};
+  for (auto i = std::size_t{0}; i < key_count; i += 1) {
+    auto key = make_input(key_length);
+    for (auto j = key_length, n = i; j > 0 && n > 0; j -= 1, n /= 10) {
+      key[j - 1] = static_cast<char>('0' + n % 10);
+    }
+    keys.push_back(S{std::string_view{key}});
+    map.emplace(keys.back(), static_cast<int>(i));
+  }
+
+  auto probe = std::size_t{0};
+  measure("hash", type, key_length, [&] { return probe++ % key_count; }, [&](std::size_t i) {
+    do_not_optimize(std::hash<S>{}(keys[i]));
+  });
+  measure("unordered_map find", type, key_length, [&] { return probe++ % key_count; }, [&](std::size_t i) {
+    auto found = map.find(keys[i]);
+    do_not_optimize(found);
+  });
+}
+
+// Looks the same long key objects up again and again, as a cache keyed on request bodies would
+template<typename S>
+void bench_long_keys_type(std::size_t key_length) {
+  auto const type = type_name<S>;
+  auto constexpr key_count = std::size_t{32};
+
+  auto keys = std::vector<S>{};
+  auto map = std::unordered_map<S, int>{};
+  for (auto i = std::size_t{0}; i < key_count; i += 1) {
+    auto key = make_input(key_length);
+    key[0] = static_cast<char>('A' + i);
+    keys.push_back(S{std::string_view{key}});
+    map.emplace(keys.back(), static_cast<int>(i));
+  }
+
+  auto probe = std::size_t{0};
+  measure("hash (long key)", type, key_length, [&] { return probe++ % key_count; }, [&](std::size_t i) {
+    do_not_optimize(std::hash<S>{}(keys[i]));
+  });
+  measure("unordered_map find (long key)", type, key_length, [&] { return probe++ % key_count; }, [&](std::size_t i) {
+    auto found = map.find(keys[i]);
+    do_not_optimize(found);
+  });
+}
+
+// Takes over a buffer that has just been filled, as an I/O layer would; std::string has to copy it.
+// The filled buffers are reused, jtstring hands each one back with release().
+template<typename S>
+void bench_adopt_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto constexpr buffer_count = std::size_t{16};
+  auto const input = make_input(size);
+
+  auto buffers = std::vector<std::unique_ptr<char[]>>{};
+  for (auto i = std::size_t{0}; i < buffer_count; i += 1) {
+    buffers.push_back(std::make_unique<char[]>(size + 1));
+    std::copy(input.begin(), input.end(), buffers.back().get());
+  }
+
+  auto next = std::size_t{0};
+  measure("construct from buffer", type, size, [&] { return &buffers[next++ % buffer_count]; }, [&](std::unique_ptr<char[]> * buffer) {
+    if constexpr (std::is_same_v<S, std::string>) {
+      auto s = S{buffer->get(), size};
+      do_not_optimize(s);
+    } else {
+      auto s = S{jtstring_buffer{std::move(*buffer), size, size}};
+      do_not_optimize(s);
+      *buffer = s.release().data;
+    }
+  }, buffer_count);
+}
+
+// Handles a request the way an HTTP handler would: a URL, eight headers and a 2 KiB body built from chunks, then a response
+// that joins them, all dropped at the end. jtstring_pooled runs it with a jtstring_pool reset after every request, and
+// jtstring_pmr with a monotonic_buffer_resource released after every request.
+template<typename S>
+void bench_request_type() {
+  auto const type = type_name<S>;
+  auto const chunk = make_input(64);
+  auto const value = make_input(40, 'v');
+
+  auto const handle = [&](std::size_t id) {
+    auto url = S{std::string_view{"https://example.com/api/v1/items/"}};
+    url += std::string_view{std::to_string(id)};
+    auto headers = std::vector<S>{};
+    for (auto i = 0; i < 8; i += 1) {
+      auto header = S{std::string_view{"X-Header-"}};
+      header += static_cast<char>('a' + i);
+      header += std::string_view{": "};
+      header += std::string_view{value};
+      headers.push_back(std::move(header));
+    }
+    auto body = S{};
+    for (auto i = 0; i < 32; i += 1) {
+      body += std::string_view{chunk};
+    }
+    auto response = S{std::string_view{"HTTP/1.1 200 OK\r\n"}};
+    for (auto const & header : headers) {
+      response += std::string_view{header};
+      response += std::string_view{"\r\n"};
+    }
+    response += std::string_view{url};
+    response += std::string_view{body};
+    return response.size();
+  };
+
+  auto id = std::size_t{0};
+  measure("handle request", type, 0, [] { return 0; }, [&](int) {
+    do_not_optimize(handle(id++));
+  }, 16);
+
+  if constexpr (std::is_same_v<S, jtstring_pooled>) {
+    auto pool = jtstring_pool{};
+    measure("handle request with jtstring_pool", type, 0, [] { return 0; }, [&](int) {
+      {
+        auto const scope = jtstring_pool_scope{pool};
+        do_not_optimize(handle(id++));
+      }
+      pool.reset();
+    }, 16);
+  } else if constexpr (std::is_same_v<S, jtstring_pmr>) {
+    auto arena = std::pmr::monotonic_buffer_resource{std::size_t{64} << 10};
+    measure("handle request with monotonic_buffer_resource", type, 0, [] { return 0; }, [&](int) {
+      {
+        auto const scope = jtstring_resource_scope{&arena};
+        do_not_optimize(handle(id++));
+      }
+      arena.release();
+    }, 16);
+  }
+}
+
+// Churns strings of 31 to 256 characters on `threads` threads at once. Each thread keeps a ring of 64 live strings
+// and replaces one at a time; the time is reported per replacement on one thread.
+template<typename S>
+void bench_churn_type(std::size_t threads) {
+  auto const type = type_name<S>;
+  auto constexpr iterations = std::size_t{1} << 16;
+  auto inputs = std::vector<std::string>{};
+  for (auto size : {31, 40, 56, 64, 100, 128, 200, 255}) {
+    inputs.push_back(make_input(static_cast<std::size_t>(size)));
+  }
+
+  measure("churn 31-255 B strings", type, threads, [] { return 0; }, [&](int) {
+    auto workers = std::vector<std::thread>{};
+    for (auto t = std::size_t{0}; t < threads; t += 1) {
+      workers.emplace_back([&, t] {
+        auto ring = std::array<S, 64>{};
+        for (auto i = std::size_t{0}; i < iterations; i += 1) {
+          ring[i % ring.size()] = S{std::string_view{inputs[(i * 7 + t) % inputs.size()]}};
+        }
+        do_not_optimize(ring);
+      });
+    }
+    for (auto & worker : workers) {
+      worker.join();
+    }
+  }, 1, iterations);
+}
+
+// Loads a column of 4096 keys of up to `max_length` characters, spread evenly over the lengths, and drops it again.
+// Reported per key; jtstring is built one by one and with from_views.
+template<typename S>
+void bench_load_keys_type(std::size_t max_length) {
+  auto const type = type_name<S>;
+  auto constexpr count = std::size_t{4096};
+  auto buffer = std::string{};
+  auto offsets = std::vector<std::size_t>{0};
+  for (auto i = std::size_t{0}; i < count; i += 1) {
+    buffer += make_input(1 + i * 37 % max_length, static_cast<char>('a' + i % 26));
+    offsets.push_back(buffer.size());
+  }
+  auto views = std::vector<std::string_view>{};
+  for (auto i = std::size_t{0}; i < count; i += 1) {
+    views.push_back(std::string_view{buffer}.substr(offsets[i], offsets[i + 1] - offsets[i]));
+  }
+
+  measure("load keys one by one", type, max_length, [] { return 0; }, [&](int) {
+    auto keys = std::vector<S>{};
+    keys.reserve(count);
+    for (auto view : views) {
+      keys.emplace_back(view);
+    }
+    do_not_optimize(keys);
+  }, 4, count);
+
+  if constexpr (!std::is_same_v<S, std::string>) {
+    measure("load keys with from_views", type, max_length, [] { return 0; }, [&](int) {
+      auto keys = std::vector<S>(count);
+      S::from_views(views, keys);
+      do_not_optimize(keys);
+    }, 4, count);
+  }
+}
+
+// Key lengths as {length, percentage} buckets, modelled on the key spaces we store
+struct key_distribution {
+  std::string_view load_benchmark;
+  std::string_view find_benchmark;
+  std::span<std::pair<std::size_t, std::size_t> const> histogram;
+};
+
+// Short ids, "user:" style names, and a large share of 31 character digests with a prefix ("sha:" and 27 hex digits)
+static constexpr std::pair<std::size_t, std::size_t> digest_key_lengths[] = {{8, 15}, {20, 20}, {30, 10}, {31, 40}, {48, 15}};
+// Dense key columns of short ids
+static constexpr std::pair<std::size_t, std::size_t> dense_key_lengths[] = {{6, 25}, {12, 40}, {16, 25}, {24, 10}};
+// Log tags of 60 to 100 bytes
+static constexpr std::pair<std::size_t, std::size_t> log_tag_lengths[] = {{40, 15}, {60, 35}, {80, 35}, {100, 15}};
+// Relative file paths
+static constexpr std::pair<std::size_t, std::size_t> path_lengths[] = {{32, 10}, {64, 30}, {96, 40}, {120, 20}};
+
+static constexpr key_distribution key_distributions[] =
+  { {"load digest keys", "find digest keys", digest_key_lengths}
+  , {"load dense keys", "find dense keys", dense_key_lengths}
+  , {"load log tags", "find log tags", log_tag_lengths}
+  , {"load paths", "find paths", path_lengths}
+  };
+
+// Builds a column of 4096 keys whose lengths follow `distribution`, reported per key with the allocations it costs,
+// then looks keys up by scanning 32 neighbours of the column. The size reported is sizeof(S), the footprint per key.
+template<typename S>
+void bench_key_distribution_type(key_distribution const & distribution) {
+  auto const type = type_name<S>;
+  auto constexpr count = std::size_t{4096};
+  auto constexpr scan = std::size_t{32};
+
+  auto keys = std::vector<std::string>{};
+  for (auto i = std::size_t{0}; i < count; i += 1) {
+    auto percentile = i * 7 % 100;
+    auto length = std::size_t{0};
+    for (auto [bucket_length, share] : distribution.histogram) {
+      length = bucket_length;
+      if (percentile < share) {
+        break;
+      }
+      percentile -= share;
+    }
+    keys.push_back(make_input(length, static_cast<char>('a' + i % 26)));
+  }
+
+  measure(distribution.load_benchmark, type, sizeof(S), [] { return 0; }, [&](int) {
+    auto column = std::vector<S>{};
+    column.reserve(count);
+    for (auto const & key : keys) {
+      column.emplace_back(std::string_view{key});
+    }
+    do_not_optimize(column);
+  }, 4, count);
+
+  auto column = std::vector<S>{};
+  for (auto const & key : keys) {
+    column.emplace_back(std::string_view{key});
+  }
+  auto probe = std::size_t{0};
+  measure(distribution.find_benchmark, type, sizeof(S), [&] { return probe++ * 97 % (count - scan); }, [&](std::size_t base) {
+    auto const first = column.begin() + static_cast<std::ptrdiff_t>(base);
+    auto found = std::find(first, first + scan, column[base + scan - 1]);
+    do_not_optimize(found);
+  });
+}
+
+// Repeated identifiers, such as metric names, of `length` characters: finds one among 64 by comparing contents,
+// and by comparing jtstring_interner handles, and interns names that are already interned one at a time and in bulk
+void bench_interner(std::size_t length) {
+  auto constexpr count = std::size_t{64};
+  auto names = std::vector<std::string>{};
+  for (auto i = std::size_t{0}; i < count; i += 1) {
+    auto name = make_input(length);
+    for (auto j = length, n = i; j > 0 && n > 0; j -= 1, n /= 10) {
+      name[j - 1] = static_cast<char>('0' + n % 10);
+    }
+    names.push_back(name);
+  }
+  auto views = std::vector<std::string_view>(names.begin(), names.end());
+
+  auto strings = std::vector<jtstring>(views.begin(), views.end());
+  auto probe = std::size_t{0};
+  measure("find identifier", type_name<jtstring>, length, [&] { return jtstring{strings[probe++ % count]}; }, [&](jtstring const & name) {
+    auto found = std::find(strings.begin(), strings.end(), name);
+    do_not_optimize(found);
+  });
+
+  auto interner = jtstring_interner{};
+  auto atoms = std::vector<jtstring_atom>(count);
+  interner.intern(views, atoms);
+  measure("find identifier", "jtstring_atom"sv, length, [&] { return atoms[probe++ % count]; }, [&](jtstring_atom name) {
+    auto found = std::find(atoms.begin(), atoms.end(), name);
+    do_not_optimize(found);
+  });
+
+  measure("intern", "jtstring_atom"sv, length, [&] { return views[probe++ % count]; }, [&](std::string_view name) {
+    do_not_optimize(interner.intern(name));
+  });
+
+  measure("intern in bulk", "jtstring_atom"sv, length, [] { return 0; }, [&](int) {
+    interner.intern(views, atoms);
+    do_not_optimize(atoms);
+  }, 16, count);
+}
+
+// Edits a document of `size` bytes in place: inserts 16 characters and erases 16 at scattered positions, so the size stays put.
+// Flat strings shift the tail on every edit, jtrope splits and joins its tree.
+template<typename S>
+void bench_edit_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto const text = make_input(16);
+  auto document = S{make_input(size)};
+  auto position = std::size_t{0};
+
+  measure("edit document", type, size, [&] { return position = (position * 6364136223846793005u + 1442695040888963407u) % size; }, [&](std::size_t pos) {
+    if constexpr (std::is_same_v<S, jtstring>) {
+      document.insert(document.cbegin() + pos % document.size(), text);
+    } else {
+      document.insert(pos % document.size(), text);
+    }
+    document.erase((pos * 7 + 5) % document.size(), text.size());
+  }, 16);
+}
+
+// Reads `size` bytes in the pattern of a socket read loop: make room for 4 KiB, receive a 1500 byte packet, keep what arrived.
+// std::string has to zero the room with resize before shrinking back.
+template<typename S>
+void bench_read_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto constexpr room = std::size_t{4096};
+  auto const packet = make_input(1500);
+
+  measure("read 1500 B packets", type, size, [] { return S{}; }, [&](S & s) {
+    while (s.size() < size) {
+      auto const old_size = s.size();
+      if constexpr (std::is_same_v<S, std::string>) {
+        s.resize(old_size + room);
+        std::memcpy(s.data() + old_size, packet.data(), packet.size());
+        s.resize(old_size + packet.size());
+      } else {
+        s.resize_and_overwrite(old_size + room, [&](char * data, std::size_t) {
+          std::memcpy(data + old_size, packet.data(), packet.size());
+          return old_size + packet.size();
+        });
+      }
+    }
+  }, std::max(std::size_t{1}, (std::size_t{1} << 20) / size), (size + packet.size() - 1) / packet.size());
+}
+
+// Builds a string out of four pieces and a number, as a log line or cache key would be built
+template<typename S>
+void bench_concat_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto const a = S{std::string_view{make_input(size, 'a')}};
+  auto const b = make_input(size, 'b');
+  auto const c = make_input(size, 'c');
+
+  measure("a + b + ':' + c + to_string(n)", type, size, [] { return 0; }, [&](int) {
+    auto s = a + b + ':' + S{std::string_view{c}} + S{std::string_view{std::to_string(size)}};
+    do_not_optimize(s);
+  });
+
+  if constexpr (!std::is_same_v<S, std::string>) {
+    measure("concat(a, b, ':', c, n)", type, size, [] { return 0; }, [&](int) {
+      auto s = S::concat(a, b, ':', c, size);
+      do_not_optimize(s);
+    });
+  }
+}
+
+// Formats a metrics line of eight counters or eight gauges, reported per number
+template<typename S>
+void bench_number_type() {
+  auto const type = type_name<S>;
+  auto constexpr count = std::size_t{8};
+
+  auto const append_line = [](S & s, auto const & values) {
+    for (auto value : values) {
+      s += "m="sv;
+      if constexpr (std::is_same_v<S, std::string>) {
+        s += std::to_string(value);
+      } else {
+        s.append_number(value);
+      }
+      s += ' ';
+    }
+  };
+
+  auto counters = std::array<std::uint64_t, count>{};
+  auto gauges = std::array<double, count>{};
+  for (auto i = std::size_t{0}; i < count; i += 1) {
+    counters[i] = (std::uint64_t{1} << (5 * i)) + i;
+    gauges[i] = static_cast<double>(counters[i]) / 7;
+  }
+
+  measure("append integers", type, 0, [] { return S{}; }, [&](S & s) { append_line(s, counters); }, ::batch_size, count);
+  measure("append doubles", type, 0, [] { return S{}; }, [&](S & s) { append_line(s, gauges); }, ::batch_size, count);
+}
+
+#if defined(JTSTRING_HAS_FORMAT)
+// Formats a log line around a message of `size` characters, as a new string and appended to a line buffer
+template<typename S>
+void bench_format_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto const message = make_input(size);
+  auto const level = "warning"sv;
+
+  measure("format(log line)", type, size, [] { return 0; }, [&](int) {
+    if constexpr (std::is_same_v<S, std::string>) {
+      auto s = jtstring_format_backend::format("[{:>8}] id={} {}", level, size, message);
+      do_not_optimize(s);
+    } else {
+      auto s = S::format("[{:>8}] id={} {}", level, size, message);
+      do_not_optimize(s);
+    }
+  });
+
+  measure("format_to(buffer, log line)", type, size, [] { return S{}; }, [&](S & s) {
+    for (auto i = 0; i < 8; i += 1) {
+      if constexpr (std::is_same_v<S, std::string>) {
+        jtstring_format_backend::format_to(std::back_inserter(s), "[{:>8}] id={} {}\n", level, i, message);
+      } else {
+        format_to(s, "[{:>8}] id={} {}\n", level, i, message);
+      }
+    }
+  }, ::batch_size, 8);
+}
+#endif
+
+// Splits `size` characters of comma separated fields of 1 to 16 characters, or of 60 character lines, summing the field lengths.
+// std::string goes through std::views::split, jtstring through its own split ranges.
+template<typename S>
+void bench_split_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto record = std::string{};
+  auto text = std::string{};
+  for (auto i = std::size_t{0}; record.size() < size; i += 1) {
+    record.append(1 + i * 7 % 16, static_cast<char>('a' + i % 26));
+    record += i % 3 == 0 ? ';' : ',';
+    text.append(59, static_cast<char>('a' + i % 26));
+    text += '\n';
+  }
+  record.resize(size);
+  text.resize(size);
+  auto const csv = S{std::string_view{record}};
+  auto const lines = S{std::string_view{text}};
+
+  auto const sum_lengths = [](auto && fields) {
+    auto total = std::size_t{0};
+    for (auto && field : fields) {
+      total += std::string_view{field.begin(), field.end()}.size();
+    }
+    return total;
+  };
+
+  measure("split(',')", type, size, [] { return 0; }, [&](int) {
+    if constexpr (std::is_same_v<S, std::string>) {
+      do_not_optimize(sum_lengths(std::views::split(csv, ',')));
+    } else {
+      do_not_optimize(sum_lengths(csv.split(',')));
+    }
+  }, 16);
+
+  measure("split_any(\",;\")", type, size, [] { return 0; }, [&](int) {
+    if constexpr (std::is_same_v<S, std::string>) {
+      auto total = std::size_t{0};
+      for (auto first = std::size_t{0}, last = std::size_t{0}; last != std::string::npos; first = last + 1) {
+        last = csv.find_first_of(",;", first);
+        total += std::string_view{csv}.substr(first, last - first).size();
+      }
+      do_not_optimize(total);
+    } else {
+      do_not_optimize(sum_lengths(csv.split_any(",;")));
+    }
+  }, 16);
+
+  measure("lines()", type, size, [] { return 0; }, [&](int) {
+    if constexpr (std::is_same_v<S, std::string>) {
+      do_not_optimize(sum_lengths(std::views::split(lines, '\n')));
+    } else {
+      do_not_optimize(sum_lengths(lines.lines()));
+    }
+  }, 16);
+}
+
+template<typename S>
+void bench_replace_all_type(std::size_t size) {
+  auto const type = type_name<S>;
+  auto const input = make_input(size);
+  auto const view = std::string_view{input};
+
+  measure("replace_all(1 -> 0)", type, size, [&] { return S{view}; }, [](S & s) {
+    replace_all(s, "z"sv, ""sv);
+  }, 16);
+
+  measure("replace_all(1 -> 1)", type, size, [&] { return S{view}; }, [](S & s) {
+    replace_all(s, "z"sv, "Z"sv);
+  }, 16);
+
+  measure("replace_all(1 -> 4)", type, size, [&] { return S{view}; }, [](S & s) {
+    replace_all(s, "z"sv, "&amp"sv);
+  }, 16);
+}
+
+void print_csv() {
+  std::printf("benchmark,type,size,iterations,ns_per_op,allocations_per_op\n");
+  for (auto const & r : results) {
+    std::printf
+      ( "\"%.*s\",%.*s,%zu,%zu,%.3f,%.3f\n"
+      , static_cast<int>(r.benchmark.size()), r.benchmark.data()
+      , static_cast<int>(r.type.size()), r.type.data()
+      , r.size
+      , r.iterations
+      , r.ns_per_op
+      , r.allocations_per_op
+      );
+  }
+}
+
+void print_json() {
+  std::printf("{\n  \"benchmarks\": [\n");
+  for (auto it = results.begin(); it != results.end(); ++it) {
+    std::printf
+      ( "    {\"benchmark\": \"%.*s\", \"type\": \"%.*s\", \"size\": %zu, \"iterations\": %zu, \"ns_per_op\": %.3f, \"allocations_per_op\": %.3f}%s\n"
+      , static_cast<int>(it->benchmark.size()), it->benchmark.data()
+      , static_cast<int>(it->type.size()), it->type.data()
+      , it->size
+      , it->iterations
+      , it->ns_per_op
+      , it->allocations_per_op
+      , it + 1 == results.end() ? "" : ","
+      );
+  }
+  std::printf("  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+  for (auto i = 1; i < argc; i += 1) {
+    auto const arg = std::string_view{argv[i]};
+    if (arg.starts_with("--format=")) {
+      options.format = arg.substr("--format="sv.size());
+    } else if (arg.starts_with("--filter=")) {
+      options.filter = arg.substr("--filter="sv.size());
+    } else if (arg.starts_with("--min-time-ms=")) {
+      options.min_time = std::chrono::milliseconds{std::atoi(argv[i] + "--min-time-ms="sv.size())};
+    } else {
+      std::fprintf(stderr, "usage: %s [--format=csv|json] [--filter=<substring>] [--min-time-ms=<ms>]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  for (auto size : sizes) {
+    bench_type<std::string>(size);
+    bench_type<jtstring>(size);
+    bench_type<jtstring_shared>(size);
+  }
+  for (auto size : {std::size_t{1} << 10, std::size_t{1} << 14, std::size_t{1} << 18}) {
+    bench_growth_type<std::string>(size);
+    bench_growth_type<jtstring>(size);
+    bench_growth_type<basic_jtstring<std::allocator<char>, jtstring_growth_one_and_half>>(size);
+    bench_growth_type<basic_jtstring<std::allocator<char>, jtstring_growth_size_class>>(size);
+  }
+  for (auto size : {std::size_t{16}, std::size_t{30}, std::size_t{256}, std::size_t{4096}, std::size_t{1} << 20}) {
+    bench_find_type<std::string_view>(size);
+    bench_find_type<jtstring>(size);
+  }
+  for (auto key_length : {std::size_t{12}, std::size_t{20}, std::size_t{30}, std::size_t{40}, std::size_t{64}}) {
+    bench_keys_type<std::string>(key_length);
+    bench_keys_type<jtstring>(key_length);
+  }
+  for (auto key_length : {std::size_t{8}, std::size_t{16}, std::size_t{30}, std::size_t{40}, std::size_t{64}}) {
+    bench_map_type<std::string>(key_length);
+    bench_map_type<jtstring>(key_length);
+  }
+  for (auto key_length : {std::size_t{256}, std::size_t{4096}, std::size_t{1} << 16, std::size_t{1} << 20}) {
+    bench_long_keys_type<std::string>(key_length);
+    bench_long_keys_type<jtstring>(key_length);
+  }
+  for (auto size : {std::size_t{4}, std::size_t{16}, std::size_t{64}, std::size_t{1024}}) {
+    bench_concat_type<std::string>(size);
+    bench_concat_type<jtstring>(size);
+  }
+  for (auto size : {std::size_t{64}, std::size_t{1024}, std::size_t{1} << 16}) {
+    bench_split_type<std::string>(size);
+    bench_split_type<jtstring>(size);
+  }
+  bench_number_type<std::string>();
+  bench_number_type<jtstring>();
+#if defined(JTSTRING_HAS_FORMAT)
+  for (auto size : {std::size_t{8}, std::size_t{64}, std::size_t{1024}}) {
+    bench_format_type<std::string>(size);
+    bench_format_type<jtstring>(size);
+  }
+#endif
+  for (auto size : {std::size_t{1} << 16, std::size_t{1} << 20}) {
+    bench_read_type<std::string>(size);
+    bench_read_type<jtstring>(size);
+  }
+  for (auto threads : {std::size_t{1}, std::size_t{4}, std::size_t{16}}) {
+    bench_churn_type<std::string>(threads);
+    bench_churn_type<jtstring>(threads);
+    bench_churn_type<jtstring_cached>(threads);
+  }
+  bench_request_type<std::string>();
+  bench_request_type<jtstring>();
+  bench_request_type<jtstring_pooled>();
+  bench_request_type<jtstring_pmr>();
+  for (auto max_length : {std::size_t{24}, std::size_t{64}, std::size_t{256}}) {
+    bench_load_keys_type<std::string>(max_length);
+    bench_load_keys_type<jtstring>(max_length);
+  }
+  for (auto const & distribution : key_distributions) {
+    bench_key_distribution_type<std::string>(distribution);
+    bench_key_distribution_type<jtstring>(distribution);
+    bench_key_distribution_type<jtstring_inline<64>>(distribution);
+    bench_key_distribution_type<jtstring_inline<128>>(distribution);
+  }
+  for (auto length : {std::size_t{16}, std::size_t{40}}) {
+    bench_interner(length);
+  }
+  for (auto size : {std::size_t{256}, std::size_t{4096}, std::size_t{1} << 20}) {
+    bench_adopt_type<std::string>(size);
+    bench_adopt_type<jtstring>(size);
+  }
+  for (auto size : {std::size_t{1} << 20, std::size_t{1} << 22}) {
+    bench_edit_type<std::string>(size);
+    bench_edit_type<jtstring>(size);
+    bench_edit_type<jtrope>(size);
+  }
+  for (auto size : {std::size_t{256}, std::size_t{1} << 16}) {
+    bench_replace_all_type<std::string>(size);
+    bench_replace_all_type<jtstring>(size);
+  }
+  bench_large_type<std::string>();
+  bench_large_type<jtstring>();
+  bench_large_type<jtstring_malloc>();
+
+  if (options.format == "json") {
+    print_json();
+  } else {
+    print_csv();
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,56 +1,1365 @@
 // Type your code here, or load an example.
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
 #include <compare>
+#include <concepts>
 #include <cstdint>
 #include <cstddef>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <functional>
 #include <initializer_list>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
 #include <numeric>
+#include <ranges>
+#include <span>
 #include <stdexcept>
+#include <system_error>
 #include <string_view>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Formatting goes through <format> when the standard library has it, or through {fmt} when JTSTRING_USE_FMT is defined
+#if defined(JTSTRING_USE_FMT)
+#include <fmt/format.h>
+#define JTSTRING_HAS_FORMAT 1
+namespace jtstring_format_backend = ::fmt;
+#elif __has_include(<format>)
+#include <format>
+#if defined(__cpp_lib_format)
+#define JTSTRING_HAS_FORMAT 1
+namespace jtstring_format_backend = ::std;
+#endif
+#endif
+
+#if defined(JTSTRING_HAS_FORMAT)
+template<typename... Args>
+using jtstring_format_string = jtstring_format_backend::format_string<Args...>;
+#endif
+
+// The last byte of both representations. A small string keeps its remaining capacity there, which is at most 127,
+// so the top bit tells the two apart and sign extending the byte gives an all ones mask for a large string only.
+enum struct jtstring_mask : int8_t { small = 0, large = -1 };
+
+// Both representations are `InlineBytes` wide: 32 is the least that holds a large string,
+// and 128 the most whose remaining capacity leaves the top bit of the last byte clear
+template<std::size_t InlineBytes>
+concept jtstring_inline_bytes = InlineBytes >= 32 && InlineBytes <= 128 && InlineBytes % alignof(std::size_t) == 0;
+
+// The size is stored as the capacity left, which is 0 for a full string and so doubles as its terminator
+template<std::size_t InlineBytes>
+  requires jtstring_inline_bytes<InlineBytes>
+struct jtstring_small {
+  static constexpr auto capacity = InlineBytes - 1;
+  std::array<char, capacity> data;
+  uint8_t remaining;
+
+  constexpr jtstring_small(std::size_t size = 0) noexcept
+    : remaining{static_cast<uint8_t>(capacity - size)}
+    {}
+
+  [[nodiscard]] constexpr auto size() const noexcept -> std::size_t {
+    return capacity - remaining;
+  }
+};
+
+// Fills a large string out to the width of the small one, taking no room at all when there is nothing to fill
+template<std::size_t Size>
+struct jtstring_padding {
+  std::array<char, Size> bytes;
+};
+
+template<>
+struct jtstring_padding<0> {};
+
+// Owns nothing itself, the buffer is allocated and freed by basic_jtstring through its allocator
+template<std::size_t InlineBytes>
+  requires jtstring_inline_bytes<InlineBytes>
+struct jtstring_large {
+  // Bits of `flags`
+  static constexpr auto hash_cached = std::uint8_t{1};
+  // The buffer is carved out of a jtstring_slab shared with other strings
+  static constexpr auto slab = std::uint8_t{2};
+  // Non-const access has handed out a pointer into the reference counted buffer, which copies must not share
+  static constexpr auto unshareable = std::uint8_t{4};
+
+  std::size_t size;
+  char * data;
+  std::size_t capacity_less_sso;
+  // 48 bits of cached hash, filled in lazily by const member functions so accessed through std::atomic_ref
+  mutable std::uint32_t hash_lo;
+  mutable std::uint16_t hash_hi;
+  mutable std::uint8_t flags;
+  [[no_unique_address]] jtstring_padding<InlineBytes - 32> padding;
+  jtstring_mask mask;
+
+  constexpr jtstring_large(std::size_t size, std::size_t capacity, char * data) noexcept
+    : size{size}
+    , data{data}
+    , capacity_less_sso{capacity - jtstring_small<InlineBytes>::capacity}
+    , hash_lo{0}
+    , hash_hi{0}
+    , flags{0}
+    , mask{jtstring_mask::large}
+    {}
+};
+
+// Makes `resource` the current resource of this thread for jtstring_resource_allocator
+// for the lifetime of the scope, e.g. to back all the strings of a request with an arena
+class jtstring_resource_scope {
+  private:
+    std::pmr::memory_resource * previous;
+
+  public:
+    [[nodiscard]] static auto current() noexcept -> std::pmr::memory_resource * & {
+      thread_local std::pmr::memory_resource * resource = std::pmr::get_default_resource();
+      return resource;
+    }
+
+    explicit jtstring_resource_scope(std::pmr::memory_resource * resource) noexcept
+      : previous{std::exchange(current(), resource)}
+      {}
+
+    ~jtstring_resource_scope() {
+      current() = previous;
+    }
+
+    jtstring_resource_scope(jtstring_resource_scope const &) = delete;
+    jtstring_resource_scope& operator=(jtstring_resource_scope const &) = delete;
+};
+
+// Stateless allocator that allocates from the calling thread's current memory resource.
+// The resource is recorded in a header in front of each buffer so that it is always freed
+// back to the resource it came from, even if the current resource has changed since.
+template<typename T>
+struct jtstring_resource_allocator {
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  static_assert(sizeof(T) == 1, "jtstring_resource_allocator only allocates character buffers");
+
+  static constexpr auto header_size = alignof(std::max_align_t);
+
+  jtstring_resource_allocator() noexcept = default;
+  template<typename U>
+  jtstring_resource_allocator(jtstring_resource_allocator<U> const &) noexcept {}
+
+  [[nodiscard]] auto allocate(std::size_t n) -> T * {
+    auto const resource = jtstring_resource_scope::current();
+    auto const block = static_cast<char *>(resource->allocate(n + header_size, header_size));
+    new(block) std::pmr::memory_resource *{resource};
+    return reinterpret_cast<T *>(block + header_size);
+  }
+
+  void deallocate(T * p, std::size_t n) noexcept {
+    auto const block = reinterpret_cast<char *>(p) - header_size;
+    auto const resource = *std::launder(reinterpret_cast<std::pmr::memory_resource **>(block));
+    resource->deallocate(block, n + header_size, header_size);
+  }
+
+  friend auto operator==(jtstring_resource_allocator const &, jtstring_resource_allocator const &) noexcept -> bool {
+    return true;
+  }
+};
+
+// Stateless allocator on top of malloc, realloc and free.
+// Its reallocate lets basic_jtstring grow large strings without a copy when the block can be
+// extended, which for huge blocks glibc does with mremap.
+template<typename T>
+struct jtstring_malloc_allocator {
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  static_assert(std::is_trivially_copyable_v<T>, "jtstring_malloc_allocator moves blocks with realloc");
+
+  jtstring_malloc_allocator() noexcept = default;
+  template<typename U>
+  jtstring_malloc_allocator(jtstring_malloc_allocator<U> const &) noexcept {}
+
+  [[nodiscard]] auto allocate(std::size_t n) -> T * {
+    if (auto const p = std::malloc(n * sizeof(T))) {
+      return static_cast<T *>(p);
+    }
+    throw std::bad_alloc{};
+  }
+
+  void deallocate(T * p, std::size_t) noexcept {
+    std::free(p);
+  }
+
+  [[nodiscard]] auto reallocate(T * p, std::size_t, std::size_t new_n) -> T * {
+    if (auto const q = std::realloc(p, new_n * sizeof(T))) {
+      return static_cast<T *>(q);
+    }
+    throw std::bad_alloc{};
+  }
+
+  friend auto operator==(jtstring_malloc_allocator const &, jtstring_malloc_allocator const &) noexcept -> bool {
+    return true;
+  }
+};
+
+// Per-thread free lists of buffers of up to 256 bytes, in size classes 16 bytes apart, behind jtstring_cached_allocator.
+// A freed buffer goes onto the freeing thread's list for its class until that holds `limit` buffers; buffers past the
+// limit, larger ones and those left on a thread's lists when it exits go back to operator delete. Buffers freed on a
+// thread after its lists are destroyed, e.g. by a thread_local string constructed before them, bypass the cache.
+class jtstring_size_class_cache {
+  public:
+    static constexpr auto granularity = std::size_t{16};
+    static constexpr auto max_size = std::size_t{256};
+    static constexpr auto class_count = max_size / granularity;
+    static constexpr auto default_limit = std::size_t{64};
+
+  private:
+    struct node {
+      node * next;
+    };
+
+    struct free_list {
+      node * head = nullptr;
+      std::size_t count = 0;
+    };
+
+    struct thread_lists {
+      std::array<free_list, class_count> lists;
+
+      ~thread_lists() {
+        destroyed() = true;
+        for (auto & list : lists) {
+          while (list.head != nullptr) {
+            ::operator delete(std::exchange(list.head, list.head->next));
+          }
+        }
+      }
+    };
+
+    struct limit_table {
+      std::array<std::atomic<std::size_t>, class_count> limits;
+
+      limit_table() noexcept {
+        for (auto & limit : limits) {
+          limit.store(default_limit, std::memory_order_relaxed);
+        }
+      }
+    };
+
+    // Trivially destructible, so it can still be read once the thread's lists are gone
+    [[nodiscard]] static auto destroyed() noexcept -> bool & {
+      thread_local auto flag = false;
+      return flag;
+    }
+
+    [[nodiscard]] static auto local() noexcept -> thread_lists * {
+      if (destroyed()) [[unlikely]] {
+        return nullptr;
+      }
+      thread_local auto lists = thread_lists{};
+      return &lists;
+    }
+
+    [[nodiscard]] static auto table() noexcept -> limit_table & {
+      static auto limits = limit_table{};
+      return limits;
+    }
+
+    // Whether `n` falls in one of the size classes, i.e. 1 <= n <= max_size
+    [[nodiscard]] static constexpr auto cached(std::size_t n) noexcept -> bool {
+      return n - 1 < max_size;
+    }
+
+    [[nodiscard]] static constexpr auto class_of(std::size_t n) noexcept -> std::size_t {
+      return (n - 1) / granularity;
+    }
+
+  public:
+    // How many buffers of `bytes` bytes each thread keeps, where 0 stops caching them. Sizes outside [1, max_size]
+    // are never cached, so setting their limit does nothing and their limit is always 0.
+    static void set_limit(std::size_t bytes, std::size_t count) noexcept {
+      if (cached(bytes)) {
+        table().limits[class_of(bytes)].store(count, std::memory_order_relaxed);
+      }
+    }
+
+    [[nodiscard]] static auto limit(std::size_t bytes) noexcept -> std::size_t {
+      return cached(bytes) ? table().limits[class_of(bytes)].load(std::memory_order_relaxed) : 0;
+    }
+
+    [[nodiscard]] static auto allocate(std::size_t n) -> char * {
+      if (cached(n)) {
+        if (auto const lists = local()) [[likely]] {
+          auto & list = lists->lists[class_of(n)];
+          if (list.head != nullptr) {
+            list.count -= 1;
+            return reinterpret_cast<char *>(std::exchange(list.head, list.head->next));
+          }
+        }
+        n = (class_of(n) + 1) * granularity;
+      }
+      return static_cast<char *>(::operator new(n));
+    }
+
+    static void deallocate(char * p, std::size_t n) noexcept {
+      if (cached(n)) {
+        if (auto const lists = local()) [[likely]] {
+          auto & list = lists->lists[class_of(n)];
+          if (list.count < limit(n)) {
+            list.head = new(p) node{list.head};
+            list.count += 1;
+            return;
+          }
+        }
+      }
+      ::operator delete(p);
+    }
+};
+
+// Stateless allocator on top of jtstring_size_class_cache, so that the heap strings just past the inline capacity
+// are recycled on the thread that frees them rather than going through the global allocator every time
+template<typename T>
+struct jtstring_cached_allocator {
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  static_assert(sizeof(T) == 1, "jtstring_cached_allocator only allocates character buffers");
+
+  jtstring_cached_allocator() noexcept = default;
+  template<typename U>
+  jtstring_cached_allocator(jtstring_cached_allocator<U> const &) noexcept {}
+
+  [[nodiscard]] auto allocate(std::size_t n) -> T * {
+    return reinterpret_cast<T *>(jtstring_size_class_cache::allocate(n));
+  }
+
+  void deallocate(T * p, std::size_t n) noexcept {
+    jtstring_size_class_cache::deallocate(reinterpret_cast<char *>(p), n);
+  }
+
+  friend auto operator==(jtstring_cached_allocator const &, jtstring_cached_allocator const &) noexcept -> bool {
+    return true;
+  }
+};
+
+// Search kernels behind basic_jtstring's find family.
+// Every kernel searches the whole of [s, s + n) and returns an offset into it or npos.
+// On x86 the SSE2 or AVX2 kernels are picked once at run time, the scalar ones are the fallback elsewhere.
+struct jtstring_search {
+  static constexpr auto npos = static_cast<std::size_t>(-1);
+
+  // Sets up to this size are compared character by character in vector registers, larger ones use a table
+  static constexpr auto max_vector_set = std::size_t{16};
+
+  // Haystacks shorter than this are not worth an indirect call into a vector kernel
+  static constexpr auto min_vector_size = std::size_t{16};
+
+  struct kernels {
+    std::size_t (*rfind_char)(char const *, std::size_t, char) noexcept;
+    std::size_t (*find)(char const *, std::size_t, std::string_view) noexcept;
+    std::size_t (*find_of)(char const *, std::size_t, std::string_view, bool) noexcept;
+    std::size_t (*rfind_of)(char const *, std::size_t, std::string_view, bool) noexcept;
+  };
+
+  [[nodiscard]] static auto offset(std::size_t base, std::size_t found) noexcept -> std::size_t {
+    return found == npos ? npos : base + found;
+  }
+
+  [[nodiscard]] static auto set_table(std::string_view set) noexcept -> std::array<bool, 256> {
+    auto table = std::array<bool, 256>{};
+    for (auto c : set) {
+      table[static_cast<unsigned char>(c)] = true;
+    }
+    return table;
+  }
+
+  [[nodiscard]] static auto scalar_find_char(char const * s, std::size_t n, char c) noexcept -> std::size_t {
+    auto const p = static_cast<char const *>(std::memchr(s, c, n));
+    return p == nullptr ? npos : static_cast<std::size_t>(p - s);
+  }
+
+  [[nodiscard]] static auto scalar_rfind_char(char const * s, std::size_t n, char c) noexcept -> std::size_t {
+    for (auto i = n; i > 0; i -= 1) {
+      if (s[i - 1] == c) {
+        return i - 1;
+      }
+    }
+    return npos;
+  }
+
+  [[nodiscard]] static auto scalar_find(char const * s, std::size_t n, std::string_view needle) noexcept -> std::size_t {
+    return std::string_view{s, n}.find(needle);
+  }
+
+  [[nodiscard]] static auto scalar_find_of(char const * s, std::size_t n, std::string_view set, bool negate) noexcept -> std::size_t {
+    auto const table = set_table(set);
+    for (auto i = std::size_t{0}; i < n; i += 1) {
+      if (table[static_cast<unsigned char>(s[i])] != negate) {
+        return i;
+      }
+    }
+    return npos;
+  }
+
+  [[nodiscard]] static auto scalar_rfind_of(char const * s, std::size_t n, std::string_view set, bool negate) noexcept -> std::size_t {
+    auto const table = set_table(set);
+    for (auto i = n; i > 0; i -= 1) {
+      if (table[static_cast<unsigned char>(s[i - 1])] != negate) {
+        return i - 1;
+      }
+    }
+    return npos;
+  }
+
+  static constexpr auto scalar_kernels = kernels
+    { scalar_rfind_char
+    , scalar_find
+    , scalar_find_of
+    , scalar_rfind_of
+    };
+
+#if defined(__SSE2__)
+  [[nodiscard]] static auto sse2_load(char const * p) noexcept -> __m128i {
+    return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+  }
+
+  [[nodiscard]] static auto sse2_match(__m128i block, __m128i c) noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, c)));
+  }
+
+  [[nodiscard]] static auto sse2_match_set(__m128i block, __m128i const * set, std::size_t set_size, bool negate) noexcept -> std::uint32_t {
+    auto matches = _mm_setzero_si128();
+    for (auto i = std::size_t{0}; i < set_size; i += 1) {
+      matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, set[i]));
+    }
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(matches)) ^ (negate ? 0xFFFFu : 0u);
+  }
+
+  [[nodiscard]] static auto sse2_rfind_char(char const * s, std::size_t n, char c) noexcept -> std::size_t {
+    auto const splat = _mm_set1_epi8(c);
+    auto i = n;
+    for (; i >= 16; i -= 16) {
+      if (auto const mask = sse2_match(sse2_load(s + i - 16), splat); mask != 0) {
+        return i - 16 + static_cast<std::size_t>(std::bit_width(mask)) - 1;
+      }
+    }
+    return scalar_rfind_char(s, i, c);
+  }
+
+  // Filters candidates on the needle's first and last characters, two blocks at a time, then compares the middle
+  [[nodiscard]] static auto sse2_find(char const * s, std::size_t n, std::string_view needle) noexcept -> std::size_t {
+    auto const m = needle.size();
+    auto const first = _mm_set1_epi8(needle.front());
+    auto const last = _mm_set1_epi8(needle.back());
+    auto i = std::size_t{0};
+    for (; i + 32 + m - 1 <= n; i += 32) {
+      auto mask
+        = (sse2_match(sse2_load(s + i), first) & sse2_match(sse2_load(s + i + m - 1), last))
+        | (sse2_match(sse2_load(s + i + 16), first) & sse2_match(sse2_load(s + i + 16 + m - 1), last)) << 16;
+      for (; mask != 0; mask &= mask - 1) {
+        auto const j = i + static_cast<std::size_t>(std::countr_zero(mask));
+        if (std::memcmp(s + j + 1, needle.data() + 1, m - 2) == 0) {
+          return j;
+        }
+      }
+    }
+    return offset(i, scalar_find(s + i, n - i, needle));
+  }
+
+  [[nodiscard]] static auto sse2_find_of(char const * s, std::size_t n, std::string_view set, bool negate) noexcept -> std::size_t {
+    if (set.size() > max_vector_set) {
+      return scalar_find_of(s, n, set, negate);
+    }
+    __m128i splats[max_vector_set];
+    for (auto i = std::size_t{0}; i < set.size(); i += 1) {
+      splats[i] = _mm_set1_epi8(set[i]);
+    }
+    auto i = std::size_t{0};
+    for (; i + 16 <= n; i += 16) {
+      if (auto const mask = sse2_match_set(sse2_load(s + i), splats, set.size(), negate); mask != 0) {
+        return i + static_cast<std::size_t>(std::countr_zero(mask));
+      }
+    }
+    return offset(i, scalar_find_of(s + i, n - i, set, negate));
+  }
+
+  [[nodiscard]] static auto sse2_rfind_of(char const * s, std::size_t n, std::string_view set, bool negate) noexcept -> std::size_t {
+    if (set.size() > max_vector_set) {
+      return scalar_rfind_of(s, n, set, negate);
+    }
+    __m128i splats[max_vector_set];
+    for (auto i = std::size_t{0}; i < set.size(); i += 1) {
+      splats[i] = _mm_set1_epi8(set[i]);
+    }
+    auto i = n;
+    for (; i >= 16; i -= 16) {
+      if (auto const mask = sse2_match_set(sse2_load(s + i - 16), splats, set.size(), negate); mask != 0) {
+        return i - 16 + static_cast<std::size_t>(std::bit_width(mask)) - 1;
+      }
+    }
+    return scalar_rfind_of(s, i, set, negate);
+  }
+
+  static constexpr auto sse2_kernels = kernels
+    { sse2_rfind_char
+    , sse2_find
+    , sse2_find_of
+    , sse2_rfind_of
+    };
+
+  [[gnu::target("avx2")]] [[nodiscard]] static auto avx2_load(char const * p) noexcept -> __m256i {
+    return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+  }
+
+  [[gnu::target("avx2")]] [[nodiscard]] static auto avx2_match(__m256i block, __m256i c) noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, c)));
+  }
+
+  [[gnu::target("avx2")]] [[nodiscard]] static auto avx2_match_set(__m256i block, __m256i const * set, std::size_t set_size, bool negate) noexcept -> std::uint32_t {
+    auto matches = _mm256_setzero_si256();
+    for (auto i = std::size_t{0}; i < set_size; i += 1) {
+      matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, set[i]));
+    }
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(matches)) ^ (negate ? 0xFFFFFFFFu : 0u);
+  }
+
+  [[gnu::target("avx2")]] [[nodiscard]] static auto avx2_rfind_char(char const * s, std::size_t n, char c) noexcept -> std::size_t {
+    auto const splat = _mm256_set1_epi8(c);
+    auto i = n;
+    for (; i >= 32; i -= 32) {
+      if (auto const mask = avx2_match(avx2_load(s + i - 32), splat); mask != 0) {
+        return i - 32 + static_cast<std::size_t>(std::bit_width(mask)) - 1;
+      }
+    }
+    return scalar_rfind_char(s, i, c);
+  }
+
+  [[gnu::target("avx2")]] [[nodiscard]] static auto avx2_find(char const * s, std::size_t n, std::string_view needle) noexcept -> std::size_t {
+    auto const m = needle.size();
+    auto const first = _mm256_set1_epi8(needle.front());
+    auto const last = _mm256_set1_epi8(needle.back());
+    auto i = std::size_t{0};
+    for (; i + 64 + m - 1 <= n; i += 64) {
+      auto const lo = _mm256_and_si256(_mm256_cmpeq_epi8(avx2_load(s + i), first), _mm256_cmpeq_epi8(avx2_load(s + i + m - 1), last));
+      auto const hi = _mm256_and_si256(_mm256_cmpeq_epi8(avx2_load(s + i + 32), first), _mm256_cmpeq_epi8(avx2_load(s + i + 32 + m - 1), last));
+      if (auto const any = _mm256_or_si256(lo, hi); _mm256_testz_si256(any, any)) {
+        continue;
+      }
+      auto mask
+        = static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(lo)))
+        | static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(hi))) << 32;
+      for (; mask != 0; mask &= mask - 1) {
+        auto const j = i + static_cast<std::size_t>(std::countr_zero(mask));
+        if (std::memcmp(s + j + 1, needle.data() + 1, m - 2) == 0) {
+          return j;
+        }
+      }
+    }
+    return offset(i, scalar_find(s + i, n - i, needle));
+  }
+
+  [[gnu::target("avx2")]] [[nodiscard]] static auto avx2_find_of(char const * s, std::size_t n, std::string_view set, bool negate) noexcept -> std::size_t {
+    if (set.size() > max_vector_set) {
+      return scalar_find_of(s, n, set, negate);
+    }
+    __m256i splats[max_vector_set];
+    for (auto i = std::size_t{0}; i < set.size(); i += 1) {
+      splats[i] = _mm256_set1_epi8(set[i]);
+    }
+    auto i = std::size_t{0};
+    for (; i + 32 <= n; i += 32) {
+      if (auto const mask = avx2_match_set(avx2_load(s + i), splats, set.size(), negate); mask != 0) {
+        return i + static_cast<std::size_t>(std::countr_zero(mask));
+      }
+    }
+    return offset(i, scalar_find_of(s + i, n - i, set, negate));
+  }
+
+  [[gnu::target("avx2")]] [[nodiscard]] static auto avx2_rfind_of(char const * s, std::size_t n, std::string_view set, bool negate) noexcept -> std::size_t {
+    if (set.size() > max_vector_set) {
+      return scalar_rfind_of(s, n, set, negate);
+    }
+    __m256i splats[max_vector_set];
+    for (auto i = std::size_t{0}; i < set.size(); i += 1) {
+      splats[i] = _mm256_set1_epi8(set[i]);
+    }
+    auto i = n;
+    for (; i >= 32; i -= 32) {
+      if (auto const mask = avx2_match_set(avx2_load(s + i - 32), splats, set.size(), negate); mask != 0) {
+        return i - 32 + static_cast<std::size_t>(std::bit_width(mask)) - 1;
+      }
+    }
+    return scalar_rfind_of(s, i, set, negate);
+  }
+
+  static constexpr auto avx2_kernels = kernels
+    { avx2_rfind_char
+    , avx2_find
+    , avx2_find_of
+    , avx2_rfind_of
+    };
+#endif
+
+  [[nodiscard]] static auto select() noexcept -> kernels const & {
+#if defined(__SSE2__)
+    static auto const & selected = [] () -> kernels const & {
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") ? avx2_kernels : sse2_kernels;
+    }();
+    return selected;
+#else
+    return scalar_kernels;
+#endif
+  }
+
+  // Bitmask of the bytes of the 32 bytes at `p` equal to `c`, in one load with AVX2 and two without
+  [[nodiscard]] static auto match_32(void const * p, char c) noexcept -> std::uint32_t {
+#if defined(__AVX2__)
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(static_cast<__m256i const *>(p)), _mm256_set1_epi8(c))));
+#elif defined(__SSE2__)
+    auto const bytes = static_cast<char const *>(p);
+    auto const splat = _mm_set1_epi8(c);
+    return sse2_match(sse2_load(bytes), splat) | (sse2_match(sse2_load(bytes + 16), splat) << 16);
+#else
+    auto const bytes = static_cast<char const *>(p);
+    auto mask = std::uint32_t{0};
+    for (auto i = 0; i < 32; i += 1) {
+      mask |= static_cast<std::uint32_t>(bytes[i] == c) << i;
+    }
+    return mask;
+#endif
+  }
+
+  // memchr is already a vector kernel with its own run time dispatch, which a plain loop here does not beat
+  [[nodiscard]] static auto find_char(char const * s, std::size_t n, char c) noexcept -> std::size_t {
+    return scalar_find_char(s, n, c);
+  }
+
+  [[nodiscard]] static auto rfind_char(char const * s, std::size_t n, char c) noexcept -> std::size_t {
+    return n < min_vector_size ? scalar_rfind_char(s, n, c) : select().rfind_char(s, n, c);
+  }
+
+  [[nodiscard]] static auto find(char const * s, std::size_t n, std::string_view needle) noexcept -> std::size_t {
+    if (needle.size() <= 1) {
+      return needle.empty() ? 0 : find_char(s, n, needle.front());
+    } else if (needle.size() > n) {
+      return npos;
+    } else {
+      return n < min_vector_size ? scalar_find(s, n, needle) : select().find(s, n, needle);
+    }
+  }
+
+  // The last occurrence of `needle` lying wholly inside [s, s + n)
+  [[nodiscard]] static auto rfind(char const * s, std::size_t n, std::string_view needle) noexcept -> std::size_t {
+    if (needle.size() <= 1) {
+      return needle.empty() ? n : rfind_char(s, n, needle.front());
+    } else if (needle.size() > n) {
+      return npos;
+    }
+    for (auto end = n - needle.size() + 1; end > 0;) {
+      auto const j = rfind_char(s, end, needle.front());
+      if (j == npos || std::memcmp(s + j + 1, needle.data() + 1, needle.size() - 1) == 0) {
+        return j;
+      }
+      end = j;
+    }
+    return npos;
+  }
+
+  [[nodiscard]] static auto find_of(char const * s, std::size_t n, std::string_view set, bool negate) noexcept -> std::size_t {
+    return n < min_vector_size ? scalar_find_of(s, n, set, negate) : select().find_of(s, n, set, negate);
+  }
+
+  [[nodiscard]] static auto rfind_of(char const * s, std::size_t n, std::string_view set, bool negate) noexcept -> std::size_t {
+    return n < min_vector_size ? scalar_rfind_of(s, n, set, negate) : select().rfind_of(s, n, set, negate);
+  }
+};
+
+// Comparison kernels behind basic_jtstring's equality, starts_with and ends_with.
+// Every basic_jtstring has at least 31 readable bytes from data(), since a small string is at least 32 bytes with the
+// characters from offset 0 and heap buffers are never smaller than 33 bytes.
+// Up to 31 characters can therefore be compared with fixed width loads and no length dependent loop.
+// A string_view promises nothing past its end, so comparisons with one use equal_exact instead.
+struct jtstring_compare {
+  // Bit i is set when byte i of the 32 bytes at `a` equals byte i of the 32 bytes at `b`
+  [[nodiscard]] static auto equal_bytes_32(void const * a, void const * b) noexcept -> std::uint32_t {
+#if defined(__AVX2__)
+    auto const lhs = _mm256_loadu_si256(static_cast<__m256i const *>(a));
+    auto const rhs = _mm256_loadu_si256(static_cast<__m256i const *>(b));
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs, rhs)));
+#elif defined(__SSE2__)
+    auto const lhs = static_cast<__m128i const *>(a);
+    auto const rhs = static_cast<__m128i const *>(b);
+    auto const lo = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(lhs), _mm_loadu_si128(rhs)));
+    auto const hi = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(lhs + 1), _mm_loadu_si128(rhs + 1)));
+    return static_cast<std::uint32_t>(lo) | static_cast<std::uint32_t>(hi) << 16;
+#else
+    auto const lhs = static_cast<char const *>(a);
+    auto const rhs = static_cast<char const *>(b);
+    auto mask = std::uint32_t{0};
+    for (auto i = 0; i < 32; i += 1) {
+      mask |= static_cast<std::uint32_t>(lhs[i] == rhs[i]) << i;
+    }
+    return mask;
+#endif
+  }
+
+  // Whether the first `n` <= 31 characters at `a` and `b` are equal, both must have 31 readable bytes
+  [[nodiscard]] static constexpr auto equal_31(char const * a, char const * b, std::size_t n) noexcept -> bool {
+    if (std::is_constant_evaluated()) {
+      return equal(a, b, n);
+    }
+#if defined(__SSE2__)
+    auto const lo = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(a)), _mm_loadu_si128(reinterpret_cast<__m128i const *>(b))));
+    auto const hi = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(a + 15)), _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + 15))));
+    auto const equal = static_cast<std::uint32_t>(lo) | static_cast<std::uint32_t>(hi) << 15;
+    return (~equal & ((std::uint32_t{1} << n) - 1)) == 0;
+#else
+    return std::memcmp(a, b, n) == 0;
+#endif
+  }
+
+  // Whether the first `n` characters at `a` and `b` are equal for 32 <= `n` <= 64, using overlapping loads from both ends
+  [[nodiscard]] static auto equal_32_to_64(char const * a, char const * b, std::size_t n) noexcept -> bool {
+#if defined(__SSE2__)
+    auto const load = [](char const * p) { return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p)); };
+    auto const head = _mm_and_si128(_mm_cmpeq_epi8(load(a), load(b)), _mm_cmpeq_epi8(load(a + 16), load(b + 16)));
+    auto const tail = _mm_and_si128(_mm_cmpeq_epi8(load(a + n - 32), load(b + n - 32)), _mm_cmpeq_epi8(load(a + n - 16), load(b + n - 16)));
+    return _mm_movemask_epi8(_mm_and_si128(head, tail)) == 0xFFFF;
+#else
+    return std::memcmp(a, b, n) == 0;
+#endif
+  }
+
+  // Whether the first `n` characters at `a` and `b` are equal, reading nothing past them: two overlapping loads from
+  // both ends of the widest size that fits, up to 64 characters, and memcmp past that
+  [[nodiscard]] static constexpr auto equal_exact(char const * a, char const * b, std::size_t n) noexcept -> bool {
+    if (std::is_constant_evaluated()) {
+      return equal(a, b, n);
+    }
+    auto const same = [a, b, n]<typename Word>(Word) {
+      Word a_head, a_tail, b_head, b_tail;
+      std::memcpy(&a_head, a, sizeof(Word));
+      std::memcpy(&b_head, b, sizeof(Word));
+      std::memcpy(&a_tail, a + n - sizeof(Word), sizeof(Word));
+      std::memcpy(&b_tail, b + n - sizeof(Word), sizeof(Word));
+      return ((a_head ^ b_head) | (a_tail ^ b_tail)) == 0;
+    };
+    if (n >= 32) {
+      return n <= 64 ? equal_32_to_64(a, b, n) : std::memcmp(a, b, n) == 0;
+    } else if (n >= 16) {
+#if defined(__SSE2__)
+      auto const load = [](char const * p) { return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p)); };
+      auto const equal = _mm_and_si128(_mm_cmpeq_epi8(load(a), load(b)), _mm_cmpeq_epi8(load(a + n - 16), load(b + n - 16)));
+      return _mm_movemask_epi8(equal) == 0xFFFF;
+#else
+      return std::memcmp(a, b, n) == 0;
+#endif
+    } else if (n >= 8) {
+      return same(std::uint64_t{});
+    } else if (n >= 4) {
+      return same(std::uint32_t{});
+    } else {
+      // The first, middle and last characters cover every length up to 3
+      return n == 0 || (a[0] == b[0] && a[n / 2] == b[n / 2] && a[n - 1] == b[n - 1]);
+    }
+  }
+
+  // memcmp for `n` characters, which are allowed to be null when `n` is 0
+  [[nodiscard]] static constexpr auto equal(char const * a, char const * b, std::size_t n) noexcept -> bool {
+    if (std::is_constant_evaluated()) {
+      return std::string_view{a, n} == std::string_view{b, n};
+    }
+    return n == 0 || std::memcmp(a, b, n) == 0;
+  }
+};
+
+// wyhash style hashing behind jtstring_hash.
+// Strings of up to 31 characters are hashed as one 32 byte block laid out like a 32 byte jtstring_small: the characters,
+// then zeros, then the remaining capacity in the last byte. A small string starts with that block, bar whatever
+// follows its end, so it is hashed with four masked loads and no branch on its length.
+struct jtstring_hashing {
+  static constexpr auto secret = std::array<std::uint64_t, 4>
+    { 0xa0761d6478bd642full
+    , 0xe7037ed1a0b428dbull
+    , 0x8ebc6af09c88c6e3ull
+    , 0x589965cc75374cc3ull
+    };
+
+  static constexpr auto max_short = std::size_t{31};
+
+  // The 128 bit product of `a` and `b` folded to 64 bits
+  [[nodiscard]] static auto mum(std::uint64_t a, std::uint64_t b) noexcept -> std::uint64_t {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    auto const product = static_cast<uint128>(a) * b;
+    return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+#else
+    auto const a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32, b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+    auto const lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    auto const cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+    auto const lo = (cross << 32) | (lo_lo & 0xFFFFFFFFu);
+    auto const hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    return lo ^ hi;
+#endif
+  }
+
+  [[nodiscard]] static auto read64(void const * p) noexcept -> std::uint64_t {
+    auto word = std::uint64_t{0};
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+  }
+
+  [[nodiscard]] static auto hash_block(std::uint64_t w0, std::uint64_t w1, std::uint64_t w2, std::uint64_t w3) noexcept -> std::size_t {
+    auto const a = mum(w0 ^ secret[0], w1 ^ secret[1]);
+    auto const b = mum(w2 ^ secret[2], w3 ^ secret[3]);
+    return static_cast<std::size_t>(mum(a ^ secret[1], b ^ secret[0]));
+  }
+
+  // 32 bytes of ones then 32 of zeros, the 32 bytes from 32 - `length` mask all but the first `length` bytes of a block
+  static constexpr auto keep_bytes = [] {
+    auto bytes = std::array<unsigned char, 64>{};
+    std::fill_n(bytes.begin(), 32, 0xFF);
+    return bytes;
+  }();
+
+  // Hashes the first `length` <= 31 of the 32 bytes at `block` as the short block of those characters
+  [[nodiscard]] static auto hash_short_block(void const * block, std::size_t length) noexcept -> std::size_t {
+    auto const bytes = static_cast<char const *>(block);
+    auto const keep = keep_bytes.data() + 32 - length;
+    return hash_block
+      ( read64(bytes) & read64(keep)
+      , read64(bytes + 8) & read64(keep + 8)
+      , read64(bytes + 16) & read64(keep + 16)
+      , (read64(bytes + 24) & read64(keep + 24)) | static_cast<std::uint64_t>(max_short - length) << 56
+      );
+  }
+
+  // Long strings hash to 48 bits, which is what jtstring_large has room to cache, spread over a whole std::size_t
+  [[nodiscard]] static auto widen(std::uint64_t hash48) noexcept -> std::size_t {
+    return static_cast<std::size_t>(hash48 * secret[2]);
+  }
+
+  [[nodiscard]] static auto hash(char const * s, std::size_t n) noexcept -> std::size_t {
+    if (n <= max_short) {
+      auto block = std::array<char, 32>{};
+      std::copy_n(s, n, block.begin());
+      return hash_short_block(block.data(), n);
+    } else {
+      return widen(hash_long(s, n));
+    }
+  }
+
+  [[nodiscard]] static auto hash_long(char const * s, std::size_t n) noexcept -> std::uint64_t {
+    auto seed = secret[0] ^ n;
+    auto i = std::size_t{0};
+    for (; i + 32 < n; i += 32) {
+      seed
+        = mum(read64(s + i) ^ secret[1], read64(s + i + 8) ^ seed)
+        ^ mum(read64(s + i + 16) ^ secret[2], read64(s + i + 24) ^ seed);
+    }
+    // The last 32 bytes, overlapping what has already been consumed
+    auto const tail = s + n - 32;
+    auto const a = mum(read64(tail) ^ secret[1], read64(tail + 8) ^ seed);
+    auto const b = mum(read64(tail + 16) ^ secret[2], read64(tail + 24) ^ seed);
+    return mum(a ^ secret[3], b ^ secret[1] ^ n) & 0xFFFF'FFFF'FFFFu;
+  }
+};
+
+// An allocator that can resize a block, keeping its contents, possibly without moving it
+template<typename Alloc>
+concept jtstring_reallocatable = requires(Alloc alloc, typename std::allocator_traits<Alloc>::pointer p, std::size_t n) {
+  { alloc.reallocate(p, n, n) } -> std::same_as<typename std::allocator_traits<Alloc>::pointer>;
+};
+
+// Growth policies decide the new capacity when a mutator outgrows the current one.
+// They are geometric so that every growing mutator is amortised O(1).
+template<typename Growth>
+concept jtstring_growth_policy = requires(std::size_t capacity, std::size_t required) {
+  { Growth::grow(capacity, required) } -> std::same_as<std::size_t>;
+};
+
+struct jtstring_growth_double {
+  [[nodiscard]] static auto grow(std::size_t capacity, std::size_t required) noexcept -> std::size_t {
+    return std::max(required, 2 * capacity);
+  }
+};
+
+struct jtstring_growth_one_and_half {
+  [[nodiscard]] static auto grow(std::size_t capacity, std::size_t required) noexcept -> std::size_t {
+    return std::max(required, capacity + capacity / 2);
+  }
+};
+
+// Grows by 1.5x and then rounds the allocation up to the end of its malloc style size class,
+// four classes per power of two, so that the slack the allocator hands out is usable capacity
+struct jtstring_growth_size_class {
+  [[nodiscard]] static auto grow(std::size_t capacity, std::size_t required) noexcept -> std::size_t {
+    auto const bytes = std::max(required, capacity + capacity / 2) + 1;
+    if (bytes <= 64) {
+      return ((bytes + 15) & ~std::size_t{15}) - 1;
+    }
+    auto const step = std::bit_floor(bytes - 1) / 4;
+    return ((bytes + step - 1) & ~(step - 1)) - 1;
+  }
+};
+
+// The decimal representation of an integer, formatted into a local buffer
+struct jtstring_digits {
+  std::array<char, std::numeric_limits<unsigned long long>::digits10 + 2> digits;
+  std::uint8_t size;
+
+  template<std::integral T>
+  explicit jtstring_digits(T value) noexcept
+    : size{static_cast<std::uint8_t>(std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr - digits.data())}
+    {}
+
+  [[nodiscard]] operator std::string_view() const noexcept { return {digits.data(), size}; }
+};
+
+// Delimiter sets of single characters for jtstring_split_view, matched 32 characters at a time
+struct jtstring_char_set {
+  char ch;
+
+  [[nodiscard]] auto contains(char c) const noexcept -> bool { return c == ch; }
+
+  [[nodiscard]] auto match_32(char const * p) const noexcept -> std::uint32_t {
+    return jtstring_search::match_32(p, ch);
+  }
+};
+
+// Small sets are one wide compare per character in the set, larger ones a lookup per character of the text
+struct jtstring_any_set {
+  std::string_view chars;
+  std::array<std::uint64_t, 4> bits = {};
+
+  jtstring_any_set() noexcept = default;
+
+  explicit jtstring_any_set(std::string_view chars) noexcept
+    : chars{chars}
+  {
+    for (auto c : chars) {
+      auto const u = static_cast<unsigned char>(c);
+      bits[u / 64] |= std::uint64_t{1} << (u % 64);
+    }
+  }
+
+  [[nodiscard]] auto contains(char c) const noexcept -> bool {
+    auto const u = static_cast<unsigned char>(c);
+    return (bits[u / 64] >> (u % 64) & 1) != 0;
+  }
+
+  [[nodiscard]] auto match_32(char const * p) const noexcept -> std::uint32_t {
+    auto mask = std::uint32_t{0};
+    if (chars.size() <= jtstring_search::max_vector_set) {
+      for (auto c : chars) {
+        mask |= jtstring_search::match_32(p, c);
+      }
+    } else {
+      for (auto i = 0; i < 32; i += 1) {
+        mask |= static_cast<std::uint32_t>(contains(p[i])) << i;
+      }
+    }
+    return mask;
+  }
+};
+
+// Finds delimiters of one character a block of 32 characters at a time, and keeps the rest of the block's matches
+// for the fields that follow, so a short field costs a bit scan rather than a call into a search kernel
+template<typename Set>
+struct jtstring_byte_delimiter {
+  Set set;
+  std::size_t base = 0;
+  std::size_t scanned = 0;
+  std::uint32_t mask = 0;
+
+  [[nodiscard]] static constexpr auto length() noexcept -> std::size_t { return 1; }
+
+  // The next delimiter at or after `from`, which is just past the previous one, or `size` when there is none
+  [[nodiscard]] auto next(char const * data, std::size_t size, std::size_t) noexcept -> std::size_t {
+    while (mask == 0) {
+      if (scanned >= size) {
+        return size;
+      }
+      base = scanned;
+      mask = scan(data, size, base);
+      scanned += 32;
+    }
+    auto const found = base + static_cast<std::size_t>(std::countr_zero(mask));
+    mask &= mask - 1;
+    return found;
+  }
+
+  // A block reaching past the end of the text is read as the tail of the last 32 characters, or copied out when the text is shorter
+  [[nodiscard]] auto scan(char const * data, std::size_t size, std::size_t base) const noexcept -> std::uint32_t {
+    if (size - base >= 32) {
+      return set.match_32(data + base);
+    } else if (size >= 32) {
+      return set.match_32(data + size - 32) >> (32 - (size - base));
+    } else {
+      auto block = std::array<char, 32>{};
+      std::memcpy(block.data(), data + base, size - base);
+      return set.match_32(block.data()) & ((std::uint32_t{1} << (size - base)) - 1);
+    }
+  }
+};
+
+// Delimiters of several characters are found with the substring search kernel; an empty one never matches
+struct jtstring_string_delimiter {
+  std::string_view needle;
+
+  [[nodiscard]] auto length() const noexcept -> std::size_t { return needle.size(); }
+
+  [[nodiscard]] auto next(char const * data, std::size_t size, std::size_t from) const noexcept -> std::size_t {
+    if (needle.empty()) {
+      return size;
+    }
+    auto const found = jtstring_search::find(data + from, size - from, needle);
+    return found == jtstring_search::npos ? size : from + found;
+  }
+};
+
+// Lines end at '\n', with a '\r' before it dropped, and the '\n' ending the last line does not start another
+struct jtstring_line_delimiter : jtstring_byte_delimiter<jtstring_char_set> {
+  jtstring_line_delimiter() noexcept
+    : jtstring_byte_delimiter<jtstring_char_set>{{'\n'}}
+  {}
+};
+
+// A lazy forward range of the fields of `text` between delimiters, as string_views into it, which never allocates.
+// There is always one more field than there are delimiters, as in a round trip through join, except with lines.
+template<typename Delimiter>
+class jtstring_split_view : public std::ranges::view_interface<jtstring_split_view<Delimiter>> {
+  static constexpr auto lines = std::is_same_v<Delimiter, jtstring_line_delimiter>;
+
+  std::string_view text;
+  Delimiter delimiter;
+
+public:
+  class iterator {
+    static constexpr auto done = static_cast<std::size_t>(-1);
+
+    char const * data = nullptr;
+    std::size_t size = 0;
+    std::size_t first = done;
+    std::size_t last = done;
+    Delimiter delimiter;
+
+  public:
+    // A Cpp17 forward iterator has to yield a real reference, the fields are returned by value
+    using iterator_category = std::input_iterator_tag;
+    using iterator_concept = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+
+    iterator(std::string_view text, Delimiter delimiter) noexcept
+      : data{text.data()}
+      , size{text.size()}
+      , first{0}
+      , delimiter{delimiter}
+    {
+      if (lines && size == 0) {
+        first = done;
+      } else {
+        last = this->delimiter.next(data, size, 0);
+      }
+    }
+
+    [[nodiscard]] auto operator*() const noexcept -> std::string_view {
+      auto n = last - first;
+      if constexpr (lines) {
+        n -= static_cast<std::size_t>(n != 0 && data[last - 1] == '\r');
+      }
+      return {data + first, n};
+    }
+
+    auto operator++() noexcept -> iterator & {
+      if (last == size) {
+        first = done;
+      } else {
+        first = last + delimiter.length();
+        if (lines && first == size) {
+          first = done;
+        } else {
+          last = delimiter.next(data, size, first);
+        }
+      }
+      return *this;
+    }
+
+    auto operator++(int) noexcept -> iterator {
+      auto const copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    [[nodiscard]] friend auto operator==(iterator const & lhs, iterator const & rhs) noexcept -> bool {
+      return lhs.first == rhs.first;
+    }
+
+    [[nodiscard]] friend auto operator==(iterator const & it, std::default_sentinel_t) noexcept -> bool {
+      return it.first == done;
+    }
+  };
+
+  jtstring_split_view() = default;
+
+  jtstring_split_view(std::string_view text, Delimiter delimiter) noexcept
+    : text{text}
+    , delimiter{delimiter}
+    {}
+
+  [[nodiscard]] auto begin() const noexcept -> iterator { return {text, delimiter}; }
+  [[nodiscard]] auto end() const noexcept -> std::default_sentinel_t { return {}; }
+};
+
+// The fields are views into the text rather than into the range, so they outlive it
+template<typename Delimiter>
+inline constexpr bool std::ranges::enable_borrowed_range<jtstring_split_view<Delimiter>> = true;
+
+// Whether copies of a heap string get a buffer of their own, or share one reference counted buffer
+// that is copied on the first write through any of them. Small strings are always copied.
+// In shared mode non-const access to the characters can allocate, and stops copies from sharing, see data().
+enum struct jtstring_ownership { unique, shared };
+
+// A heap buffer from new[] passed into or out of basic_jtstring without copying the characters.
+// `data` holds `capacity` + 1 characters, room for the terminator after a full buffer, the first `size` of which are
+// the string, and `size` must not exceed `capacity`.
+struct jtstring_buffer {
+  std::unique_ptr<char[]> data;
+  std::size_t size;
+  std::size_t capacity;
+};
+
+// One allocation holding the heap buffers of a batch of strings, each preceded by a pointer back to this header.
+// It is freed along with the last of its buffers.
+struct jtstring_slab {
+  std::atomic<std::size_t> references;
+  std::size_t bytes;
+
+  static constexpr auto header_size = alignof(std::max_align_t);
+  static constexpr auto link_size = sizeof(jtstring_slab *);
+
+  // The space a buffer of `size` characters and its terminator takes up, with its back pointer
+  [[nodiscard]] static constexpr auto entry_size(std::size_t size) noexcept -> std::size_t {
+    return (link_size + size + 1 + link_size - 1) & ~(link_size - 1);
+  }
+
+  [[nodiscard]] static auto owner(char * data) noexcept -> jtstring_slab * {
+    return *std::launder(reinterpret_cast<jtstring_slab **>(data - link_size));
+  }
+};
+
+// Bump allocator for the heap buffers of strings that all die together, such as those of one request.
+// Strings opt in through jtstring_pool_allocator, as jtstring_pooled does, which allocates from the pool made current
+// on the thread by jtstring_pool_scope. reset() frees all their buffers at once, and must not happen while any of those
+// strings is still in use. A pool is only ever used by one thread at a time.
+class jtstring_pool {
+  private:
+    struct slab {
+      slab * next;
+      std::size_t size;
+    };
+
+    static constexpr auto header_size = alignof(std::max_align_t);
+    static constexpr auto alignment = alignof(std::max_align_t);
+
+    std::size_t slab_size;
+    slab * first = nullptr;
+    slab * current = nullptr;
+    char * cursor = nullptr;
+    char * limit = nullptr;
+
+    [[nodiscard]] static auto begin_of(slab * s) noexcept -> char * {
+      return reinterpret_cast<char *>(s) + header_size;
+    }
+
+    // Moves on to the next slab that can hold `n` bytes, reusing those kept from before the last reset
+    // and linking in a new one after the current slab otherwise
+    void next_slab(std::size_t n) {
+      auto next = current == nullptr ? first : current->next;
+      while (next != nullptr && next->size < n) {
+        next = next->next;
+      }
+      if (next == nullptr) {
+        auto const size = std::max(slab_size, n);
+        next = new(::operator new(header_size + size)) slab{nullptr, size};
+        if (current == nullptr) {
+          next->next = first;
+          first = next;
+        } else {
+          next->next = current->next;
+          current->next = next;
+        }
+      }
+      current = next;
+      cursor = begin_of(next);
+      limit = cursor + next->size;
+    }
+
+  public:
+    explicit jtstring_pool(std::size_t slab_size = std::size_t{64} << 10) noexcept
+      : slab_size{slab_size}
+      {}
+
+    ~jtstring_pool() {
+      while (first != nullptr) {
+        ::operator delete(std::exchange(first, first->next));
+      }
+    }
+
+    jtstring_pool(jtstring_pool const &) = delete;
+    jtstring_pool& operator=(jtstring_pool const &) = delete;
+
+    [[nodiscard]] static auto current_pool() noexcept -> jtstring_pool * & {
+      thread_local jtstring_pool * pool = nullptr;
+      return pool;
+    }
+
+    [[nodiscard]] static constexpr auto rounded(std::size_t n) noexcept -> std::size_t {
+      return (n + alignment - 1) & ~(alignment - 1);
+    }
+
+    [[nodiscard]] auto allocate(std::size_t n) -> char * {
+      n = rounded(n);
+      if (static_cast<std::size_t>(limit - cursor) < n) {
+        next_slab(n);
+      }
+      return std::exchange(cursor, cursor + n);
+    }
+
+    // Grows the buffer of `old_n` bytes at `p` to `new_n` bytes where it is, if it is the last one handed out
+    // and its slab has room, so that a string being appended to does not move at every step
+    [[nodiscard]] auto try_extend(char * p, std::size_t old_n, std::size_t new_n) noexcept -> bool {
+      if (p + rounded(old_n) != cursor || static_cast<std::size_t>(limit - p) < rounded(new_n)) {
+        return false;
+      }
+      cursor = p + rounded(new_n);
+      return true;
+    }
+
+    // Frees every buffer handed out so far in O(1), keeping the slabs for the buffers to come
+    void reset() noexcept {
+      current = nullptr;
+      cursor = nullptr;
+      limit = nullptr;
+    }
+};
+
+// Makes `pool` the current pool of this thread for the lifetime of the scope
+class jtstring_pool_scope {
+  private:
+    jtstring_pool * previous;
+
+  public:
+    explicit jtstring_pool_scope(jtstring_pool & pool) noexcept
+      : previous{std::exchange(jtstring_pool::current_pool(), &pool)}
+      {}
+
+    ~jtstring_pool_scope() {
+      jtstring_pool::current_pool() = previous;
+    }
+
+    jtstring_pool_scope(jtstring_pool_scope const &) = delete;
+    jtstring_pool_scope& operator=(jtstring_pool_scope const &) = delete;
+};
+
+// Stateless allocator that allocates from the calling thread's current jtstring_pool, or from operator new while there is none.
+// As with jtstring_resource_allocator, the owner is recorded in a header in front of each buffer, so that a buffer grows
+// within and is freed back to the pool it came from, whichever pool is current by then. Freeing a pooled buffer does nothing,
+// the pool's reset() frees them all.
+template<typename T>
+struct jtstring_pool_allocator {
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  static_assert(sizeof(T) == 1, "jtstring_pool_allocator only allocates character buffers");
+
+  static constexpr auto header_size = alignof(std::max_align_t);
+
+  jtstring_pool_allocator() noexcept = default;
+  template<typename U>
+  jtstring_pool_allocator(jtstring_pool_allocator<U> const &) noexcept {}
+
+  [[nodiscard]] auto allocate(std::size_t n) -> T * {
+    return allocate_from(jtstring_pool::current_pool(), n);
+  }
+
+  void deallocate(T * p, std::size_t n) noexcept {
+    auto const block = reinterpret_cast<char *>(p) - header_size;
+    if (owner(block) == nullptr) {
+      ::operator delete(block, n + header_size);
+    }
+  }
+
+  // Extends the buffer where it is when it is the last one its pool handed out, so that a string being appended to
+  // does not move at every step, and moves it to a new buffer from the same owner otherwise
+  [[nodiscard]] auto reallocate(T * p, std::size_t n, std::size_t new_n) -> T * {
+    auto const block = reinterpret_cast<char *>(p) - header_size;
+    auto const pool = owner(block);
+    if (pool != nullptr && pool->try_extend(block, n + header_size, new_n + header_size)) {
+      return p;
+    }
+    auto const q = allocate_from(pool, new_n);
+    std::memcpy(q, p, std::min(n, new_n));
+    deallocate(p, n);
+    return q;
+  }
 
-enum struct jtstring_mask : int8_t { small = 0, large = -1 };
+  friend auto operator==(jtstring_pool_allocator const &, jtstring_pool_allocator const &) noexcept -> bool {
+    return true;
+  }
 
-struct jtstring_small {
-  static constexpr auto capacity = std::size_t{30};
-  uint8_t size;
-  std::array<char, capacity> data;
-  jtstring_mask mask;
+  private:
+    [[nodiscard]] static auto owner(char * block) noexcept -> jtstring_pool * {
+      return *std::launder(reinterpret_cast<jtstring_pool **>(block));
+    }
 
-  jtstring_small(std::size_t size = 0) noexcept
-    : size{static_cast<uint8_t>(size)}
-    , mask{jtstring_mask::small}
-    {}
+    [[nodiscard]] static auto allocate_from(jtstring_pool * pool, std::size_t n) -> T * {
+      auto const block = pool != nullptr ? pool->allocate(n + header_size) : static_cast<char *>(::operator new(n + header_size));
+      new(block) jtstring_pool *{pool};
+      return reinterpret_cast<T *>(block + header_size);
+    }
 };
 
-struct jtstring_large {
-  std::size_t size;
-  std::unique_ptr<char[]> data;
-  std::size_t capacity_less_sso;
-  std::array<char, 7> padding;
-  jtstring_mask mask;
+// `InlineBytes` is the size of the object and so one more than the number of characters stored inline
+template<typename Alloc = std::allocator<char>, jtstring_growth_policy Growth = jtstring_growth_double, jtstring_ownership Ownership = jtstring_ownership::unique, std::size_t InlineBytes = 32>
+  requires jtstring_inline_bytes<InlineBytes>
+class basic_jtstring {
+  public:
+    static constexpr auto npos = static_cast<std::size_t>(-1);
 
-  jtstring_large(std::size_t size, std::size_t capacity)
-    : size{size}
-    // TODO: Better for c++20
-    //, data{std::make_unique_for_overwrite<char[]>(capacity + 1)}
-    , data{std::make_unique<char[]>(capacity + 1)}
-    , capacity_less_sso{capacity - jtstring_small::capacity}
-    , mask{jtstring_mask::large}
-    {}
-};
+    using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<char>;
+
+  private:
+    using allocator_traits = std::allocator_traits<allocator_type>;
+    using jtstring_small = ::jtstring_small<InlineBytes>;
+    using jtstring_large = ::jtstring_large<InlineBytes>;
+
+    static_assert(sizeof(jtstring_large) == sizeof(jtstring_small), "Short string and long string should be the same size");
+    static_assert(offsetof(jtstring_large, mask) == offsetof(jtstring_small, remaining), "Short string and long string should share their last byte");
+
+    // There is no room for allocator state in the object, so allocators are default constructed on use
+    static_assert(allocator_traits::is_always_equal::value, "basic_jtstring requires a stateless allocator");
 
-static_assert(sizeof(jtstring_large) == sizeof(jtstring_small), "Short string and long string should be the same size");
-static_assert(offsetof(jtstring_large, size) == offsetof(jtstring_small, size), "Short string and long string should have size at the same offset");
-static_assert(offsetof(jtstring_large, mask) == offsetof(jtstring_small, mask), "Short string and long string should have mask at the same offset");
+    // The small string is exactly the 32 byte block that the single load kernels work on
+    static constexpr auto compact = InlineBytes == 32;
 
-class jtstring {
   public:
-    static constexpr auto npos = static_cast<std::size_t>(-1);
+    // The most characters stored in the object itself
+    static constexpr auto inline_capacity = jtstring_small::capacity;
 
   private:
     union {
@@ -58,28 +1367,187 @@ class jtstring {
       jtstring_small small;
     };
 
+    static constexpr auto shared = Ownership == jtstring_ownership::shared;
+
+    // In shared mode every heap buffer is preceded by its reference count
+    static constexpr auto refcount_size = shared ? alignof(std::max_align_t) : std::size_t{0};
+
+    [[nodiscard]] static auto refcount(char * data) noexcept -> std::atomic<std::size_t> & {
+      return *std::launder(reinterpret_cast<std::atomic<std::size_t> *>(data - refcount_size));
+    }
+
+    // The default allocator's buffers come from new[], so that jtstring_buffers can be adopted and released without a copy
+    static constexpr auto new_buffers = std::is_same_v<allocator_type, std::allocator<char>> && !shared;
+
+    // The buffer is left uninitialised, every caller overwrites it up to and including the terminator
+    [[nodiscard]] static auto allocate(std::size_t capacity) -> char * {
+      if constexpr (new_buffers) {
+        return new char[capacity + 1];
+      } else {
+        auto alloc = allocator_type{};
+        auto const block = allocator_traits::allocate(alloc, refcount_size + capacity + 1);
+        if constexpr (shared) {
+          new(block) std::atomic<std::size_t>{1};
+        }
+        return block + refcount_size;
+      }
+    }
+
+    static void deallocate(char * data, std::size_t capacity) noexcept {
+      if constexpr (new_buffers) {
+        delete[] data;
+      } else {
+        auto alloc = allocator_type{};
+        allocator_traits::deallocate(alloc, data - refcount_size, refcount_size + capacity + 1);
+      }
+    }
+
+    // Makes this a heap string with a new buffer
+    auto new_large(std::size_t size, std::size_t capacity) -> char * {
+      new(&large) jtstring_large{size, capacity, allocate(capacity)};
+      return large.data;
+    }
+
+    // Drops this string's reference to its heap buffer, freeing the buffer with the last reference
+    void drop_buffer() noexcept {
+      if constexpr (shared) {
+        if (refcount(large.data).fetch_sub(1, std::memory_order_acq_rel) != 1) {
+          return;
+        }
+      } else if (large.flags & jtstring_large::slab) {
+        release_slab(jtstring_slab::owner(large.data), 1);
+        return;
+      }
+      deallocate(large.data, capacity());
+    }
+
+    static void release_slab(jtstring_slab * slab, std::size_t references) noexcept {
+      if (slab->references.fetch_sub(references, std::memory_order_acq_rel) == references) {
+        auto alloc = allocator_type{};
+        auto const bytes = slab->bytes;
+        slab->~jtstring_slab();
+        allocator_traits::deallocate(alloc, reinterpret_cast<char *>(slab), bytes);
+      }
+    }
+
+    // Gives this string a heap buffer of its own before its characters are written to
+    void detach() {
+      if constexpr (shared) {
+        if (is_large() && refcount(large.data).load(std::memory_order_acquire) != 1) {
+          char * it;
+          auto tmp = basic_jtstring{size(), capacity(), &it};
+          std::copy(large.data, large.data + size() + 1, it);
+          swap(*this, tmp);
+        }
+      }
+    }
+
+    // Grows the buffer of a large string to `new_cap` through the allocator's reallocate, keeping its contents.
+    // Returns false, leaving the string untouched, if the caller has to build a new string instead.
+    [[nodiscard]] auto try_grow_in_place(std::size_t new_cap) -> bool {
+      if constexpr (jtstring_reallocatable<allocator_type> && !shared) {
+        if (is_large() && !(large.flags & jtstring_large::slab)) {
+          auto alloc = allocator_type{};
+          large.data = alloc.reallocate(large.data, capacity() + 1, new_cap + 1);
+          large.capacity_less_sso = new_cap - jtstring_small::capacity;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // The capacity to grow to when `required` characters no longer fit
+    [[nodiscard]] auto grown_capacity(std::size_t required) const noexcept -> std::size_t {
+      return Growth::grow(capacity(), required);
+    }
+
+    // Whether `view` points into this string's buffer, which reallocating would invalidate
+    [[nodiscard]] auto aliases(std::string_view view) const noexcept -> bool {
+      auto const less = std::less<char const *>{};
+      return !less(view.data(), begin()) && less(view.data(), begin() + capacity() + 1);
+    }
+
+    // Constant evaluation only ever makes small strings, and could not read the inactive large member to find out
+    [[nodiscard]] constexpr auto is_large() const noexcept -> bool {
+      if (std::is_constant_evaluated()) {
+        return false;
+      }
+      return static_cast<std::int8_t>(large.mask) < 0;
+    }
+
+    // All ones for a large string and zero for a small one, whose remaining capacity the shift discards
     [[nodiscard]] auto mask_sx() const noexcept -> uintptr_t {
-      return static_cast<intptr_t>(large.mask);
+      return static_cast<intptr_t>(large.mask) >> 7;
     }
 
+    // What size() loads for a small string instead of the first word, which overlaps its characters
+    static constexpr auto no_size = std::size_t{0};
+
+    // `if_large` under an all ones mask and `if_small` under a zero one, without a branch
+    template<typename T>
+    [[nodiscard]] static auto select(uintptr_t mask, T * if_large, T * if_small) noexcept -> T * {
+      return reinterpret_cast<T *>((mask & reinterpret_cast<uintptr_t>(if_large)) | (~mask & reinterpret_cast<uintptr_t>(if_small)));
+    }
+
+    // Writes both representations through the mask: a small string keeps its first word and gets its remaining capacity,
+    // a large string gets its size and keeps the all ones tag byte.
+    // The terminator of a full small string is the tag byte, so size() is not to be read between writing either.
     void set_size(std::size_t size) noexcept {
-      large.size = size | (large.size & (~this->mask_sx() << 8));
+      auto const mask = mask_sx();
+      auto sink = std::size_t{0};
+      *select(mask, &large.size, &sink) = size;
+      small.remaining = static_cast<std::uint8_t>((jtstring_small::capacity - size) | mask);
     }
 
-  public:
-    [[nodiscard]] auto data() noexcept -> char * {
+    // Everything that can modify the characters goes through the non-const data(), so clearing the cached hash there
+    // covers every mutator and every write made through what non-const access hands out before the next hash().
+    // Plain accesses are enough as nothing may run concurrently with a non-const member, and testing before clearing
+    // keeps the store, and the cost of the whole check, out of loops that index a string
+    void invalidate_hash() noexcept {
+      if (is_large() && (large.flags & jtstring_large::hash_cached)) [[unlikely]] {
+        large.flags &= static_cast<std::uint8_t>(~jtstring_large::hash_cached);
+      }
+    }
+
+    // The characters for the mutators to write, detaching a shared buffer first
+    [[nodiscard]] auto mutable_data() noexcept(!shared) -> char * {
+      detach();
+      invalidate_hash();
       auto const mask = mask_sx();
-      return reinterpret_cast<char *>((mask & reinterpret_cast<uintptr_t>(large.data.get())) | (~mask & reinterpret_cast<uintptr_t>(&small.data)));
+      return reinterpret_cast<char *>((mask & reinterpret_cast<uintptr_t>(large.data)) | (~mask & reinterpret_cast<uintptr_t>(&small.data)));
     }
 
-    [[nodiscard]] auto data() const noexcept -> char const * {
+  public:
+    // Non-const access to the characters: data(), begin(), end(), operator[], at(), front(), back() and the iterators
+    // that erase() returns. In shared mode each of these detaches a shared buffer, which allocates and so may throw,
+    // and then marks the buffer as unshareable: the caller may keep the pointer and write through it later,
+    // so copies of this string get a buffer of their own until it next reallocates.
+    [[nodiscard]] auto data() noexcept(!shared) -> char * {
+      auto const result = mutable_data();
+      if constexpr (shared) {
+        if (is_large()) {
+          large.flags |= jtstring_large::unshareable;
+        }
+      }
+      return result;
+    }
+
+    // Constant evaluation has no reinterpret_cast, it only ever has small strings anyway
+    [[nodiscard]] constexpr auto data() const noexcept -> char const * {
+      if (std::is_constant_evaluated()) {
+        return small.data.data();
+      }
       auto const mask = mask_sx();
-      return reinterpret_cast<char const *>((mask & reinterpret_cast<uintptr_t>(large.data.get())) | (~mask & reinterpret_cast<uintptr_t>(&small.data)));
+      return reinterpret_cast<char const *>((mask & reinterpret_cast<uintptr_t>(large.data)) | (~mask & reinterpret_cast<uintptr_t>(&small.data)));
     }
 
-    [[nodiscard]] auto size() const noexcept -> std::size_t {
-      auto const mask = mask_sx() | 0xFF;
-      return large.size & mask;
+    // Selects between the two representations with the mask, like data(), rather than branching
+    [[nodiscard]] constexpr auto size() const noexcept -> std::size_t {
+      if (std::is_constant_evaluated()) {
+        return small.size();
+      }
+      auto const mask = mask_sx();
+      return *select(mask, &large.size, &no_size) | (~mask & small.size());
     }
 
     [[nodiscard]] auto capacity() const noexcept -> std::size_t {
@@ -87,86 +1555,250 @@ class jtstring {
       return small.data.size() + (large.capacity_less_sso & mask);
     }
 
-    [[nodiscard]] auto view() const { return std::string_view{data(), size()}; }
+    [[nodiscard]] constexpr auto view() const { return std::string_view{data(), size()}; }
+
+    // Equal to jtstring_hash of view(), small strings are hashed straight from the object.
+    // The hash of a long heap string is cached until the next non-const access: every mutator, data(), begin(), end(),
+    // operator[], at(), front() and back() clear it. Like a mutator invalidates std::string's references,
+    // hash() ends the use of pointers, references and iterators obtained before it for writing:
+    // a write through one of them after hash() is not seen by the next hash(), obtain it again instead.
+    [[nodiscard]] auto hash() const noexcept -> std::size_t {
+      static_assert(offsetof(jtstring_small, data) == 0, "A small string starts with jtstring_hashing's short block");
+      if (!is_large()) {
+        auto const n = small.size();
+        if (compact || n <= jtstring_hashing::max_short) {
+          return jtstring_hashing::hash_short_block(&small, n);
+        }
+        return jtstring_hashing::widen(jtstring_hashing::hash_long(small.data.data(), n));
+      } else if (large.size <= jtstring_hashing::max_short) {
+        return jtstring_hashing::hash(large.data, large.size);
+      }
+
+      auto flags = std::atomic_ref{large.flags};
+      auto hash_lo = std::atomic_ref{large.hash_lo};
+      auto hash_hi = std::atomic_ref{large.hash_hi};
+      if (flags.load(std::memory_order_acquire) & jtstring_large::hash_cached) {
+        return jtstring_hashing::widen(hash_lo.load(std::memory_order_relaxed) | std::uint64_t{hash_hi.load(std::memory_order_relaxed)} << 32);
+      }
+      auto const hash48 = jtstring_hashing::hash_long(large.data, large.size);
+      hash_lo.store(static_cast<std::uint32_t>(hash48), std::memory_order_relaxed);
+      hash_hi.store(static_cast<std::uint16_t>(hash48 >> 32), std::memory_order_relaxed);
+      flags.fetch_or(jtstring_large::hash_cached, std::memory_order_release);
+      return jtstring_hashing::widen(hash48);
+    }
 
-    [[nodiscard]] auto begin()       noexcept { return data(); }
-    [[nodiscard]] auto begin() const noexcept { return data(); }
-    [[nodiscard]] auto end()       noexcept { return data() + size(); }
-    [[nodiscard]] auto end() const noexcept { return data() + size(); }
+    [[nodiscard]] auto begin()       noexcept(!shared) { return data(); }
+    [[nodiscard]] constexpr auto begin() const noexcept { return data(); }
+    [[nodiscard]] auto end()       noexcept(!shared) { return data() + size(); }
+    [[nodiscard]] constexpr auto end() const noexcept { return data() + size(); }
 
-    friend void swap(jtstring & lhs, jtstring & rhs) {
+    friend void swap(basic_jtstring & lhs, basic_jtstring & rhs) noexcept {
       std::swap(lhs.small, rhs.small);
     }
 
-    jtstring() {
-      new(&small) jtstring_small{};
-      small.data[0] = '\0';
+    // The constructors from characters are constexpr for strings that fit inline, constants of any other size do not compile.
+    // Constants have every byte of the inline buffer initialised.
+    constexpr basic_jtstring() {
+      std::construct_at(&small);
+      if (std::is_constant_evaluated()) {
+        small.data.fill('\0');
+      } else {
+        small.data[0] = '\0';
+      }
     }
 
-    jtstring(std::size_t capacity) {
+    basic_jtstring(std::size_t capacity) {
       if (capacity <= jtstring_small::capacity) {
         new(&small) jtstring_small{0};
         small.data[0] = '\0';
       } else {
-        new(&large) jtstring_large{0, capacity};
-        large.data[0] = '\0';
+        new_large(0, capacity)[0] = '\0';
       }
     }
 
   private:
-    jtstring(std::size_t size, std::size_t capacity, char** it) {
+    constexpr basic_jtstring(std::size_t size, std::size_t capacity, char** it) {
       if (capacity <= jtstring_small::capacity) {
-        new(&small) jtstring_small{size};
+        std::construct_at(&small, size);
         *it = small.data.data();
+      } else if (std::is_constant_evaluated()) {
+        throw std::out_of_range{"jtstring: constant strings must fit inline"};
       } else {
-        new(&large) jtstring_large{size, capacity};
-        *it = large.data.get();
+        *it = new_large(size, capacity);
       }
     }
 
   public:
-    ~jtstring() {
-      if (static_cast<bool>(large.mask)) {
-        large.~jtstring_large();
+    constexpr ~basic_jtstring() {
+      if (is_large()) {
+        drop_buffer();
       }
     }
 
-    jtstring(jtstring&& that) : small{std::exchange(that.small, {})} {}
+    // Moves are noexcept, so that containers move strings when they reallocate rather than copying them
+    constexpr basic_jtstring(basic_jtstring&& that) noexcept : small{std::exchange(that.small, {})} {}
 
-    jtstring& operator=(jtstring&& that) {
-      auto tmp = std::move(that);
-      swap(*this, tmp);
+    // Drops the old buffer straight away rather than swapping it into a temporary, which is a measurable part of
+    // replacing a heap string
+    basic_jtstring& operator=(basic_jtstring&& that) noexcept {
+      if (this != &that) {
+        if (is_large()) {
+          drop_buffer();
+        }
+        small = std::exchange(that.small, {});
+      }
       return *this;
     }
 
   private:
-    jtstring(std::string_view view, char * it)
-      : jtstring{view.size(), view.size(), &it}
+    constexpr basic_jtstring(std::string_view view, char * it)
+      : basic_jtstring{view.size(), view.size(), &it}
     {
-      it = std::copy(view.begin(), view.end(), it);
-      *it = '\0';
+      if (std::is_constant_evaluated()) {
+        // A full string is terminated by its tag byte, which is not part of `data`
+        std::fill(std::copy(view.begin(), view.end(), small.data.begin()), small.data.end(), '\0');
+      } else {
+        it = std::copy(view.begin(), view.end(), it);
+        *it = '\0';
+      }
     }
   public:
-    jtstring(std::string_view view) : jtstring{view, nullptr} {}
+    constexpr basic_jtstring(std::string_view view) : basic_jtstring{view, nullptr} {}
 
-    jtstring& operator=(std::string_view view) {
+    basic_jtstring& operator=(std::string_view view) {
       if (view.size() <= this->capacity()) {
-        set_size(view.size());
-        auto it = std::copy(view.begin(), view.end(), this->data());
+        auto it = std::copy(view.begin(), view.end(), mutable_data());
         *it = '\0';
+        set_size(view.size());
       } else {
-        auto tmp = jtstring{view};
+        auto tmp = basic_jtstring{view};
         swap(*this, tmp);
       }
       return *this;
     }
 
-    jtstring(jtstring const & that) : jtstring{that.view()} {}
+    constexpr basic_jtstring(basic_jtstring const & that) requires (!shared) : basic_jtstring{that.view()} {}
+
+    basic_jtstring(basic_jtstring const & that) requires shared : small{that.small} {
+      if (!is_large()) {
+        return;
+      } else if (large.flags & jtstring_large::unshareable) {
+        auto tmp = basic_jtstring{that.view()};
+        small = std::exchange(tmp.small, {});
+      } else {
+        refcount(large.data).fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    basic_jtstring& operator=(basic_jtstring const & that) requires (!shared) { return *this = that.view(); }
+
+    basic_jtstring& operator=(basic_jtstring const & that) requires shared {
+      auto tmp = that;
+      swap(*this, tmp);
+      return *this;
+    }
+
+    constexpr basic_jtstring(char const * str) : basic_jtstring{std::string_view{str}} {}
+
+    // Takes ownership of `buffer` and writes the terminator at `buffer.size`. Only strings whose own buffers come
+    // from new[] adopt it, and only when it does not fit inline; otherwise the characters are copied into a buffer
+    // from the string's allocator and `buffer` is freed. Shared strings need a reference count in front of their
+    // buffer, so they never adopt.
+    explicit basic_jtstring(jtstring_buffer buffer) requires (!shared) {
+      if (buffer.size > buffer.capacity) {
+        throw std::length_error{"jtstring: buffer size past its capacity"};
+      }
+      if (new_buffers && buffer.capacity > jtstring_small::capacity) {
+        new(&large) jtstring_large{buffer.size, buffer.capacity, buffer.data.release()};
+        large.data[buffer.size] = '\0';
+      } else {
+        auto tmp = basic_jtstring{std::string_view{buffer.data.get(), buffer.size}};
+        new(&small) jtstring_small{std::exchange(tmp.small, {})};
+      }
+    }
+    basic_jtstring& operator=(char const * str) { return *this = std::string_view{str}; }
+
+  private:
+    // Copies up to 32 characters as two fixed size copies that may overlap, rather than calling memcpy
+    static void copy_inline(char * dst, char const * src, std::size_t n) noexcept {
+      if (n > 32) {
+        std::memcpy(dst, src, n);
+      } else if (n >= 16) {
+        std::memcpy(dst, src, 16);
+        std::memcpy(dst + n - 16, src + n - 16, 16);
+      } else if (n >= 8) {
+        std::memcpy(dst, src, 8);
+        std::memcpy(dst + n - 8, src + n - 8, 8);
+      } else if (n >= 4) {
+        std::memcpy(dst, src, 4);
+        std::memcpy(dst + n - 4, src + n - 4, 4);
+      } else {
+        for (auto i = std::size_t{0}; i < n; i += 1) {
+          dst[i] = src[i];
+        }
+      }
+    }
+
+  public:
+    // Replaces the first strings of `out` with the strings of `views`, in place. The small ones are written straight into
+    // the objects; the buffers of all the heap ones are carved out of one jtstring_slab, so the batch costs one allocation
+    // rather than one per string. Shared strings keep a reference count in front of each buffer, so they are built one by one.
+    // The slab comes from a default constructed allocator_type, like every other buffer, so only the allocator's static or
+    // thread-local state, such as the current resource or pool, decides where it lives.
+    // Each view may point into the string of `out` it replaces, whose buffer is only dropped once the view has been
+    // copied, so strings can be rebuilt from slices of themselves; a view must not point into any other string of `out`.
+    static void from_views(std::span<std::string_view const> views, std::span<basic_jtstring> out) {
+      if (out.size() < views.size()) {
+        throw std::out_of_range{"jtstring: Fewer strings than views"};
+      }
+
+      auto heap_count = std::size_t{0};
+      auto heap_bytes = std::size_t{0};
+      if constexpr (!shared) {
+        for (auto view : views) {
+          if (view.size() > jtstring_small::capacity) {
+            heap_count += 1;
+            heap_bytes += jtstring_slab::entry_size(view.size());
+          }
+        }
+      }
 
-    jtstring& operator=(jtstring const & that) { return *this = that.view(); }
+      auto slab = static_cast<jtstring_slab *>(nullptr);
+      auto entry = static_cast<char *>(nullptr);
+      if (heap_count != 0) {
+        auto alloc = allocator_type{};
+        auto const bytes = jtstring_slab::header_size + heap_bytes;
+        auto const block = allocator_traits::allocate(alloc, bytes);
+        slab = new(block) jtstring_slab{{heap_count}, bytes};
+        entry = block + jtstring_slab::header_size;
+      }
 
-    jtstring(char const * str) : jtstring{std::string_view{str}} {}
-    jtstring& operator=(char const * str) { return *this = std::string_view{str}; }
+      for (auto i = std::size_t{0}; i < views.size(); i += 1) {
+        auto const view = views[i];
+        auto & str = out[i];
+        if (view.size() <= jtstring_small::capacity) {
+          auto small = jtstring_small{view.size()};
+          copy_inline(small.data.data(), view.data(), view.size());
+          small.data.data()[view.size()] = '\0';
+          if (str.is_large()) {
+            str.drop_buffer();
+          }
+          str.small = small;
+        } else if (slab == nullptr) {
+          str = view;
+        } else {
+          new(entry) jtstring_slab *{slab};
+          auto const data = entry + jtstring_slab::link_size;
+          *std::copy(view.begin(), view.end(), data) = '\0';
+          if (str.is_large()) {
+            str.drop_buffer();
+          }
+          new(&str.large) jtstring_large{view.size(), view.size(), data};
+          str.large.flags = jtstring_large::slab;
+          entry += jtstring_slab::entry_size(view.size());
+        }
+      }
+    }
 
     auto at(std::size_t i) -> char & {
       if (i >= size()) {
@@ -175,7 +1807,7 @@ class jtstring {
         return data()[i];
       }
     }
-    auto at(std::size_t i) const -> char const & {
+    constexpr auto at(std::size_t i) const -> char const & {
       if (i >= size()) {
         throw std::out_of_range{"jtstring: Index out of range"};
       } else {
@@ -183,14 +1815,14 @@ class jtstring {
       }
     }
     [[nodiscard]] auto operator[](std::size_t i)       -> char       & { return data()[i]; }
-    [[nodiscard]] auto operator[](std::size_t i) const -> char const & { return data()[i]; }
+    [[nodiscard]] constexpr auto operator[](std::size_t i) const -> char const & { return data()[i]; }
 
     [[nodiscard]] auto front()       -> char       & { return (*this)[0]; }
-    [[nodiscard]] auto front() const -> char const & { return (*this)[0]; }
+    [[nodiscard]] constexpr auto front() const -> char const & { return (*this)[0]; }
     [[nodiscard]] auto back()       -> char       & { return (*this)[size() - 1]; }
-    [[nodiscard]] auto back() const -> char const & { return (*this)[size() - 1]; }
+    [[nodiscard]] constexpr auto back() const -> char const & { return (*this)[size() - 1]; }
 
-    [[nodiscard]] auto c_str() const { return data(); }
+    [[nodiscard]] constexpr auto c_str() const { return data(); }
 
     [[nodiscard]] operator std::string_view() const { return view(); }
 
@@ -204,19 +1836,19 @@ class jtstring {
     [[nodiscard]] auto crbegin() const { return rbegin(); }
     [[nodiscard]] auto crend() const { return rend(); }
 
-    [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+    [[nodiscard]] constexpr auto empty() const -> bool { return size() == 0; }
 
-    [[nodiscard]] auto length() const { return size(); }
+    [[nodiscard]] constexpr auto length() const { return size(); }
 
     [[nodiscard]] auto max_size() const noexcept {
       return std::numeric_limits<std::size_t>::max();
     }
 
     void reserve(std::size_t new_cap) {
-      if (new_cap > capacity()) {
+      if (new_cap > capacity() && !try_grow_in_place(new_cap)) {
         char * it;
-        auto tmp = jtstring{size(), new_cap, &it};
-        it = std::copy(begin(), end(), it);
+        auto tmp = basic_jtstring{size(), new_cap, &it};
+        it = std::copy(cbegin(), cend(), it);
         *it = '\0';
         swap(*this, tmp);
       }
@@ -225,8 +1857,8 @@ class jtstring {
     void shrink_to_fit() {
       if (size() < capacity()) {
         char * it;
-        auto tmp = jtstring{size(), size(), &it};
-        it = std::copy(begin(), end(), it);
+        auto tmp = basic_jtstring{size(), size(), &it};
+        it = std::copy(cbegin(), cend(), it);
         *it = '\0';
         swap(*this, tmp);
       }
@@ -234,19 +1866,41 @@ class jtstring {
 
     void clear() {
       set_size(0);
-      data()[0] = '\0';
+      mutable_data()[0] = '\0';
     }
 
-    auto insert(char const * cpos, std::size_t count, char ch) -> jtstring & {
-      if (size() + count <= capacity()) {
-        auto pos = const_cast<char *>(cpos);
-        auto it = std::copy(cpos, cend(), pos + count);
-        *it = '\0';
+    // Hands the characters over as a new[] buffer and leaves the string empty.
+    // Heap buffers of the default allocator are handed over as they are, anything else is copied.
+    [[nodiscard]] auto release() -> jtstring_buffer requires (!shared) {
+      auto buffer = jtstring_buffer{nullptr, size(), capacity()};
+      if (new_buffers && is_large() && !(large.flags & jtstring_large::slab)) {
+        buffer.data.reset(large.data);
+      } else {
+        buffer.data = std::make_unique_for_overwrite<char[]>(size() + 1);
+        buffer.capacity = size();
+        std::copy_n(c_str(), size() + 1, buffer.data.get());
+        if (is_large()) {
+          drop_buffer();
+        }
+      }
+      new(&small) jtstring_small{};
+      small.data[0] = '\0';
+      return buffer;
+    }
+
+    auto insert(char const * cpos, std::size_t count, char ch) -> basic_jtstring & {
+      auto const index = static_cast<std::size_t>(cpos - cbegin());
+      if (size() + count <= capacity() || try_grow_in_place(grown_capacity(size() + count))) {
+        auto const pos = mutable_data() + index;
+        cpos = pos;
+        auto const new_size = size() + count;
+        std::copy_backward(cpos, cend(), mutable_data() + new_size);
+        mutable_data()[new_size] = '\0';
         std::fill_n(pos, count, ch);
-        set_size(size() + count);
+        set_size(new_size);
       } else {
         char * it;
-        auto tmp = jtstring{size() + count, (size() + count) * 2, &it};
+        auto tmp = basic_jtstring{size() + count, grown_capacity(size() + count), &it};
         it = std::copy(cbegin(), cpos, it);
         it = std::fill_n(it, count, ch);
         it = std::copy(cpos, cend(), it);
@@ -256,16 +1910,19 @@ class jtstring {
       return *this;
     }
 
-    auto insert(char const * cpos, std::string_view view) -> jtstring & {
-      if (size() + view.size() <= capacity()) {
-        auto pos = const_cast<char *>(cpos);
-        auto it = std::copy(cpos, cend(), pos + view.size());
-        *it = '\0';
+    auto insert(char const * cpos, std::string_view view) -> basic_jtstring & {
+      auto const index = static_cast<std::size_t>(cpos - cbegin());
+      if (size() + view.size() <= capacity() || (!aliases(view) && try_grow_in_place(grown_capacity(size() + view.size())))) {
+        auto const pos = mutable_data() + index;
+        cpos = pos;
+        auto const new_size = size() + view.size();
+        std::copy_backward(cpos, cend(), mutable_data() + new_size);
+        mutable_data()[new_size] = '\0';
         std::copy(view.begin(), view.end(), pos);
-        set_size(size() + view.size());
+        set_size(new_size);
       } else {
         char * it;
-        auto tmp = jtstring{size() + view.size(), (size() + view.size()) * 2, &it};
+        auto tmp = basic_jtstring{size() + view.size(), grown_capacity(size() + view.size()), &it};
         it = std::copy(cbegin(), cpos, it);
         it = std::copy(view.begin(), view.end(), it);
         it = std::copy(cpos, cend(), it);
@@ -275,21 +1932,21 @@ class jtstring {
       return *this;
     }
 
-    auto erase(char const * first, char const * last) noexcept -> char * {
-      auto first2 = const_cast<char *>(first);
-      for (auto end_it = end(); last != end_it; first2 += 1, last += 1) {
-        *first2 = *last;
-      }
-      set_size(first2 - begin());
+    auto erase(char const * first, char const * last) noexcept(!shared) -> char * {
+      auto const index = static_cast<std::size_t>(first - cbegin());
+      auto first2 = mutable_data() + index;
+      last = first2 + (last - first);
+      first2 = std::copy(static_cast<char const *>(last), cend(), first2);
+      set_size(first2 - cbegin());
       *first2 = '\0';
-      return const_cast<char *>(first);
+      return begin() + index;
     }
 
-    auto erase(std::size_t index = 0, std::size_t count = npos) -> jtstring & {
+    auto erase(std::size_t index = 0, std::size_t count = npos) -> basic_jtstring & {
       if (index > size()) {
         throw std::out_of_range{"jtstring: erase index out of range"};
       }
-      erase(begin() + index, begin() + index + std::min(count, size() - index));
+      erase(cbegin() + index, cbegin() + index + std::min(count, size() - index));
       return *this;
     }
 
@@ -298,124 +1955,466 @@ class jtstring {
     }
 
     void push_back(char ch) {
-      if (size() < capacity()) {
-        data()[size()] = ch;
-        set_size(size() + 1);
-        data()[size()] = '\0';
+      if (size() < capacity() || try_grow_in_place(grown_capacity(size() + 1))) {
+        auto const old_size = size();
+        auto const it = mutable_data() + old_size;
+        it[0] = ch;
+        it[1] = '\0';
+        set_size(old_size + 1);
       } else {
         char * it;
-        auto tmp = jtstring{size() + 1, 2 * capacity(), &it};
-        it = std::copy(begin(), end(), it);
+        auto tmp = basic_jtstring{size() + 1, grown_capacity(size() + 1), &it};
+        it = std::copy(cbegin(), cend(), it);
         *(it++) = ch;
         *(it++) = '\0';
         swap(*this, tmp);
       }
     }
 
-    void pop_back() { erase(end() - 1); }
+    void pop_back() { erase(cend() - 1); }
 
-    auto append(std::size_t count, char ch) -> jtstring & {
-      if (size() + count <= capacity()) {
-        auto it = std::fill_n(end(), count, ch);
+    auto append(std::size_t count, char ch) -> basic_jtstring & {
+      if (size() + count <= capacity() || try_grow_in_place(grown_capacity(size() + count))) {
+        auto const new_size = size() + count;
+        auto it = std::fill_n(mutable_data() + size(), count, ch);
         *it = '\0';
-        set_size(size() + count);
+        set_size(new_size);
       } else {
         char * it;
-        auto tmp = jtstring{size() + count, (size() + count) * 2, &it};
-        it = std::copy(begin(), end(), it);
+        auto tmp = basic_jtstring{size() + count, grown_capacity(size() + count), &it};
+        it = std::copy(cbegin(), cend(), it);
         it = std::fill_n(it, count, ch);
+        *it = '\0';
         swap(*this, tmp);
       }
       return *this;
     }
 
-    auto append(std::string_view view) -> jtstring & {
-      if (size() + view.size() <= capacity()) {
-        auto it = std::copy(view.begin(), view.end(), end());
+    auto append(std::string_view view) -> basic_jtstring & {
+      if (size() + view.size() <= capacity() || (!aliases(view) && try_grow_in_place(grown_capacity(size() + view.size())))) {
+        auto const new_size = size() + view.size();
+        auto it = std::copy(view.begin(), view.end(), mutable_data() + size());
         *it = '\0';
-        set_size(size() + view.size());
+        set_size(new_size);
       } else {
         char * it;
-        auto tmp = jtstring{size() + view.size(), (size() + view.size()) * 2, &it};
-        it = std::copy(begin(), end(), it);
+        auto tmp = basic_jtstring{size() + view.size(), grown_capacity(size() + view.size()), &it};
+        it = std::copy(cbegin(), cend(), it);
         it = std::copy(view.begin(), view.end(), it);
+        *it = '\0';
         swap(*this, tmp);
       }
       return *this;
     }
 
-    auto operator+=(std::string_view rhs) -> jtstring & {
+  private:
+    // Appends the output of `format(first, last)`, a call to std::to_chars producing at most `max_size` characters.
+    // It is written straight into the spare capacity when that is known to be enough, otherwise into a buffer on the stack.
+    // Output without a useful bound, such as fixed precision, or with a bound beyond the stack buffer is tried in place
+    // and grows the string until it fits.
+    template<typename Format>
+    auto append_formatted(std::size_t max_size, Format format) -> basic_jtstring & {
+      auto buffer = std::array<char, std::max(max_integer_chars<unsigned long long>, max_shortest_chars<long double>)>{};
+      if (capacity() - size() < max_size && max_size <= buffer.size()) {
+        auto const last = format(buffer.data(), buffer.data() + buffer.size()).ptr;
+        return append(std::string_view{buffer.data(), last});
+      }
+
+      auto const first = mutable_data() + size();
+      if (auto const [last, ec] = format(first, mutable_data() + capacity()); ec == std::errc{}) {
+        *last = '\0';
+        set_size(static_cast<std::size_t>(last - mutable_data()));
+        return *this;
+      }
+      reserve(grown_capacity(capacity() + buffer.size()));
+      return append_formatted(max_size, format);
+    }
+
+    [[nodiscard]] static constexpr auto decimal_digits(int n) noexcept -> std::size_t {
+      return n < 10 ? 1 : 1 + decimal_digits(n / 10);
+    }
+
+    // Bounds on the length of std::to_chars output: in any base the digits of base 2 and a sign, in base 10 the decimal
+    // digits and a sign, so that most numbers fit the inline buffer, and for the shortest round trip a sign, the digits,
+    // a point and an exponent down to that of the smallest subnormal
+    template<typename T>
+    static constexpr auto max_integer_chars = static_cast<std::size_t>(std::numeric_limits<T>::digits + 2);
+
+    template<typename T>
+    static constexpr auto max_decimal_chars = static_cast<std::size_t>(std::numeric_limits<T>::digits10 + 2);
+
+    template<typename T>
+    static constexpr auto max_shortest_chars = static_cast<std::size_t>(std::numeric_limits<T>::max_digits10 + 4)
+      + decimal_digits(std::max(std::numeric_limits<T>::max_exponent10, std::numeric_limits<T>::max_digits10 - std::numeric_limits<T>::min_exponent10));
+
+  public:
+    // Appends `value` as std::to_chars, which for floating point is the shortest representation that reads back exactly
+    template<typename T>
+      requires std::is_arithmetic_v<T>
+    auto append_number(T value) -> basic_jtstring & {
+      static_assert(!std::is_same_v<T, bool>, "append_number does not format bool");
+      if constexpr (std::integral<T>) {
+        return append_formatted(max_decimal_chars<T>, [value](char * first, char * last) { return std::to_chars(first, last, value); });
+      } else {
+        return append_formatted(max_shortest_chars<T>, [value](char * first, char * last) { return std::to_chars(first, last, value); });
+      }
+    }
+
+    template<std::integral T>
+    auto append_number(T value, int base) -> basic_jtstring & {
+      static_assert(!std::is_same_v<T, bool>, "append_number does not format bool");
+      return append_formatted(max_integer_chars<T>, [value, base](char * first, char * last) { return std::to_chars(first, last, value, base); });
+    }
+
+    template<std::floating_point T>
+    auto append_number(T value, std::chars_format fmt) -> basic_jtstring & {
+      return append_formatted(npos, [value, fmt](char * first, char * last) { return std::to_chars(first, last, value, fmt); });
+    }
+
+    template<std::floating_point T>
+    auto append_number(T value, std::chars_format fmt, int precision) -> basic_jtstring & {
+      return append_formatted(npos, [value, fmt, precision](char * first, char * last) { return std::to_chars(first, last, value, fmt, precision); });
+    }
+
+#if defined(JTSTRING_HAS_FORMAT)
+    // Formats straight into the spare capacity, or into a buffer on the stack when there is less of it than that,
+    // through the contiguous output the formatting library writes in bulk.
+    // Output that fits neither is only counted; the string then grows to fit and is formatted once more.
+    // Forwarding the arguments twice is fine, as formatting only takes references to them.
+    template<typename... Args>
+    auto append_format(jtstring_format_string<Args...> pattern, Args &&... args) -> basic_jtstring & {
+      auto const old_size = size();
+      auto const spare = capacity() - old_size;
+      auto buffer = std::array<char, 256>{};
+      auto const on_stack = spare < buffer.size();
+      auto const first = on_stack ? buffer.data() : mutable_data() + old_size;
+      auto const count = static_cast<std::size_t>(jtstring_format_backend::format_to_n(first, on_stack ? buffer.size() : spare, pattern, std::forward<Args>(args)...).size);
+      if (on_stack && count <= buffer.size()) {
+        return append(std::string_view{buffer.data(), count});
+      }
+      if (count > spare) {
+        reserve(grown_capacity(old_size + count));
+        jtstring_format_backend::format_to(mutable_data() + old_size, pattern, std::forward<Args>(args)...);
+      }
+      set_size(old_size + count);
+      mutable_data()[old_size + count] = '\0';
+      return *this;
+    }
+
+    template<typename... Args>
+    [[nodiscard]] static auto format(jtstring_format_string<Args...> pattern, Args &&... args) -> basic_jtstring {
+      auto str = basic_jtstring{};
+      str.append_format(pattern, std::forward<Args>(args)...);
+      return str;
+    }
+#endif
+
+    auto operator+=(std::string_view rhs) -> basic_jtstring & {
       return append(rhs);
     }
 
-    auto operator+=(char ch) -> jtstring & {
+    auto operator+=(char ch) -> basic_jtstring & {
       return *this += {&ch, 1};
     }
 
     // TODO compare
 
-    auto starts_with(std::string_view sv) const noexcept -> bool {
-      if (size() < sv.size()) {
+    constexpr auto starts_with(std::string_view sv) const noexcept -> bool {
+      return size() >= sv.size() && jtstring_compare::equal_exact(data(), sv.data(), sv.size());
+    }
+
+    constexpr auto starts_with(basic_jtstring const & str) const noexcept -> bool {
+      if (size() < str.size()) {
         return false;
+      } else if (str.size() <= 31) {
+        return jtstring_compare::equal_31(data(), str.data(), str.size());
+      } else {
+        return jtstring_compare::equal_exact(data(), str.data(), str.size());
+      }
+    }
+
+    constexpr auto starts_with(char c) const noexcept -> bool {
+      return size() > 0 && front() == c;
+    }
+
+    constexpr auto starts_with(char const * str) const -> bool {
+      if (std::is_constant_evaluated()) {
+        return view().starts_with(str);
+      }
+      // Only looks as far into `str` as could still match
+      auto const terminator = static_cast<char const *>(std::memchr(str, '\0', size() + 1));
+      return terminator != nullptr && jtstring_compare::equal_exact(data(), str, static_cast<std::size_t>(terminator - str));
+    }
+
+    constexpr auto ends_with(std::string_view sv) const noexcept -> bool {
+      return size() >= sv.size() && jtstring_compare::equal_exact(end() - sv.size(), sv.data(), sv.size());
+    }
+
+    constexpr auto ends_with(char c) const noexcept -> bool {
+      return size() > 0 && back() == c;
+    }
+
+    constexpr auto ends_with(char const * str) const -> bool {
+      return ends_with(std::string_view{str});
+    }
+
+    // Lazy ranges of string_views into this string, which must outlive them
+    [[nodiscard]] auto split(char delimiter) const & noexcept -> jtstring_split_view<jtstring_byte_delimiter<jtstring_char_set>> {
+      return {view(), {{delimiter}}};
+    }
+
+    [[nodiscard]] auto split(std::string_view delimiter) const & noexcept -> jtstring_split_view<jtstring_string_delimiter> {
+      return {view(), {delimiter}};
+    }
+
+    [[nodiscard]] auto split_any(std::string_view delimiters) const & noexcept -> jtstring_split_view<jtstring_byte_delimiter<jtstring_any_set>> {
+      return {view(), {jtstring_any_set{delimiters}}};
+    }
+
+    [[nodiscard]] auto lines() const & noexcept -> jtstring_split_view<jtstring_line_delimiter> {
+      return {view(), {}};
+    }
+
+    void split(char) const && = delete;
+    void split(std::string_view) const && = delete;
+    void split_any(std::string_view) const && = delete;
+    void lines() const && = delete;
+
+  private:
+    // Scans the inline buffer for `ch` with a single wide compare, ignoring the tag byte. Only compact strings fit in the one load.
+    [[nodiscard]] auto small_matches(char ch) const noexcept -> std::uint32_t {
+      static_assert(!compact || (sizeof(jtstring_small) == 32 && offsetof(jtstring_small, data) == 0), "small_matches loads the whole small string at once");
+      return jtstring_search::match_32(&small, ch) & ((std::uint32_t{1} << size()) - 1);
+    }
+
+  public:
+    [[nodiscard]] constexpr auto find(std::string_view sv, std::size_t pos = 0) const noexcept -> std::size_t {
+      if (std::is_constant_evaluated()) {
+        return view().find(sv, pos);
+      } else if (pos > size()) {
+        return npos;
+      }
+      return jtstring_search::offset(pos, jtstring_search::find(data() + pos, size() - pos, sv));
+    }
+
+    [[nodiscard]] constexpr auto find(char ch, std::size_t pos = 0) const noexcept -> std::size_t {
+      if (std::is_constant_evaluated()) {
+        return view().find(ch, pos);
+      } else if (pos >= size()) {
+        return npos;
+      } else if (compact && !is_large()) {
+        auto const matches = small_matches(ch) >> pos;
+        return matches == 0 ? npos : pos + static_cast<std::size_t>(std::countr_zero(matches));
+      } else {
+        return jtstring_search::offset(pos, jtstring_search::find_char(data() + pos, size() - pos, ch));
+      }
+    }
+
+    [[nodiscard]] auto rfind(std::string_view sv, std::size_t pos = npos) const noexcept -> std::size_t {
+      if (sv.size() > size()) {
+        return npos;
+      }
+      return jtstring_search::rfind(data(), std::min(pos, size() - sv.size()) + sv.size(), sv);
+    }
+
+    [[nodiscard]] auto rfind(char ch, std::size_t pos = npos) const noexcept -> std::size_t {
+      if (empty()) {
+        return npos;
+      }
+      auto const n = std::min(pos, size() - 1) + 1;
+      if (compact && !is_large()) {
+        auto const matches = small_matches(ch) & ((std::uint32_t{2} << (n - 1)) - 1);
+        return matches == 0 ? npos : static_cast<std::size_t>(std::bit_width(matches)) - 1;
+      } else {
+        return jtstring_search::rfind_char(data(), n, ch);
+      }
+    }
+
+    [[nodiscard]] auto find_first_of(std::string_view set, std::size_t pos = 0) const noexcept -> std::size_t {
+      if (pos >= size()) {
+        return npos;
+      }
+      return jtstring_search::offset(pos, jtstring_search::find_of(data() + pos, size() - pos, set, false));
+    }
+
+    [[nodiscard]] auto find_first_of(char ch, std::size_t pos = 0) const noexcept -> std::size_t {
+      return find(ch, pos);
+    }
+
+    [[nodiscard]] auto find_last_of(std::string_view set, std::size_t pos = npos) const noexcept -> std::size_t {
+      if (empty()) {
+        return npos;
+      }
+      return jtstring_search::rfind_of(data(), std::min(pos, size() - 1) + 1, set, false);
+    }
+
+    [[nodiscard]] auto find_last_of(char ch, std::size_t pos = npos) const noexcept -> std::size_t {
+      return rfind(ch, pos);
+    }
+
+    [[nodiscard]] auto find_first_not_of(std::string_view set, std::size_t pos = 0) const noexcept -> std::size_t {
+      if (pos >= size()) {
+        return npos;
+      }
+      return jtstring_search::offset(pos, jtstring_search::find_of(data() + pos, size() - pos, set, true));
+    }
+
+    [[nodiscard]] auto find_first_not_of(char ch, std::size_t pos = 0) const noexcept -> std::size_t {
+      return find_first_not_of({&ch, 1}, pos);
+    }
+
+    [[nodiscard]] auto find_last_not_of(std::string_view set, std::size_t pos = npos) const noexcept -> std::size_t {
+      if (empty()) {
+        return npos;
+      }
+      return jtstring_search::rfind_of(data(), std::min(pos, size() - 1) + 1, set, true);
+    }
+
+    [[nodiscard]] auto find_last_not_of(char ch, std::size_t pos = npos) const noexcept -> std::size_t {
+      return find_last_not_of({&ch, 1}, pos);
+    }
+
+    [[nodiscard]] auto contains(std::string_view sv) const noexcept -> bool {
+      return find(sv) != npos;
+    }
+
+    [[nodiscard]] auto contains(char ch) const noexcept -> bool {
+      return find(ch) != npos;
+    }
+
+    [[nodiscard]] auto contains(char const * str) const -> bool {
+      return contains(std::string_view{str});
+    }
+
+  private:
+    // Replaces the `count` characters at `index` with `count2` characters written by `write(dest)`.
+    // The tail is shifted in place when the result fits, otherwise the result is built in one new buffer.
+    // `aliasing` says that `write` reads from this string, which rules out modifying it in place.
+    template<typename Write>
+    auto replace_with(std::size_t index, std::size_t count, std::size_t count2, bool aliasing, Write write) -> basic_jtstring & {
+      auto const new_size = size() - count + count2;
+      if (!aliasing && (new_size <= capacity() || try_grow_in_place(grown_capacity(new_size)))) {
+        auto const pos = mutable_data() + index;
+        std::memmove(pos + count2, pos + count, size() - index - count);
+        write(pos);
+        set_size(new_size);
+        mutable_data()[new_size] = '\0';
+      } else {
+        char * it;
+        auto tmp = basic_jtstring{new_size, new_size <= capacity() ? capacity() : grown_capacity(new_size), &it};
+        it = std::copy(cbegin(), cbegin() + index, it);
+        write(it);
+        it = std::copy(cbegin() + index + count, cend(), it + count2);
+        *it = '\0';
+        swap(*this, tmp);
       }
+      return *this;
+    }
 
-      auto it = begin();
-      for (auto c : sv) {
-        if (c != *it) {
-          return false;
-        }
-        it += 1;
+    // Copies `source` to `dest` with every occurrence of `needle` replaced by `replacement`, scanning left to right.
+    // `dest` may overlap `source` provided the output never overtakes the input still to be read.
+    static auto replace_all_into(char * dest, std::string_view source, std::string_view needle, std::string_view replacement) noexcept -> char * {
+      auto read = std::size_t{0};
+      for (auto match = jtstring_search::find(source.data(), source.size(), needle); match != npos;) {
+        std::memmove(dest, source.data() + read, match - read);
+        dest += match - read;
+        dest = std::copy(replacement.begin(), replacement.end(), dest);
+        read = match + needle.size();
+        match = jtstring_search::offset(read, jtstring_search::find(source.data() + read, source.size() - read, needle));
       }
-      return true;
+      std::memmove(dest, source.data() + read, source.size() - read);
+      return dest + (source.size() - read);
     }
 
-    auto starts_with(char c) const noexcept -> bool {
-      return size() > 0 && front() == c;
+  public:
+    auto replace(char const * first, char const * last, std::string_view sv) -> basic_jtstring & {
+      return replace_with
+        ( static_cast<std::size_t>(first - cbegin())
+        , static_cast<std::size_t>(last - first)
+        , sv.size()
+        , aliases(sv)
+        , [sv](char * dest) { std::copy(sv.begin(), sv.end(), dest); }
+        );
     }
 
-    auto starts_with(char const * str) const -> bool {  
-      for (auto it = begin(); *str != '\0'; it += 1, str += 1) {
-        if (it == end() || *it != *str) {
-          return false;
-        }
+    auto replace(std::size_t pos, std::size_t count, std::string_view sv) -> basic_jtstring & {
+      if (pos > size()) {
+        throw std::out_of_range{"jtstring: replace pos out of range"};
       }
-      return true;
+      return replace(cbegin() + pos, cbegin() + pos + std::min(count, size() - pos), sv);
     }
 
-    auto ends_with(std::string_view sv) const noexcept -> bool {
-      if (size() < sv.size()) {
-        return false;
-      }
+    auto replace(char const * first, char const * last, std::size_t count2, char ch) -> basic_jtstring & {
+      return replace_with
+        ( static_cast<std::size_t>(first - cbegin())
+        , static_cast<std::size_t>(last - first)
+        , count2
+        , false
+        , [count2, ch](char * dest) { std::fill_n(dest, count2, ch); }
+        );
+    }
 
-      auto it = end() - sv.size();
-      for (auto c : sv) {
-        if (c != *it) {
-          return false;
-        }
-        it += 1;
+    auto replace(std::size_t pos, std::size_t count, std::size_t count2, char ch) -> basic_jtstring & {
+      if (pos > size()) {
+        throw std::out_of_range{"jtstring: replace pos out of range"};
       }
-      return true;
+      return replace(cbegin() + pos, cbegin() + pos + std::min(count, size() - pos), count2, ch);
     }
 
-    auto ends_with(char c) const noexcept -> bool {
-      return size() > 0 && back() == c;
-    }
+    // Replaces every non-overlapping occurrence of `needle`, found left to right.
+    // Replacements no longer than the needle are compacted in place in a single pass. Longer ones count the matches
+    // first, to know the final size, and then rewrite the string in a second pass: in place from a copy moved to the
+    // end of the buffer when the result fits the capacity, otherwise into one allocation of the final size.
+    auto replace_all(std::string_view needle, std::string_view replacement) -> basic_jtstring & {
+      if (needle.empty()) {
+        return *this;
+      } else if (aliases(needle) || aliases(replacement)) {
+        return replace_all(basic_jtstring{needle}, basic_jtstring{replacement});
+      }
 
-    auto ends_with(char const * str) const -> bool {
-      return ends_with(std::string_view{str});
-    }
+      auto const first = find(needle);
+      if (first == npos) {
+        return *this;
+      }
+
+      if (replacement.size() <= needle.size()) {
+        auto const data = mutable_data();
+        auto const last = replace_all_into(data + first, view().substr(first), needle, replacement);
+        auto const new_size = static_cast<std::size_t>(last - data);
+        set_size(new_size);
+        data[new_size] = '\0';
+        return *this;
+      }
 
-    // TODO: contains
+      auto matches = std::size_t{1};
+      for (auto pos = find(needle, first + needle.size()); pos != npos; pos = find(needle, pos + needle.size())) {
+        matches += 1;
+      }
 
-    // TODO: replace
+      auto const new_size = size() + matches * (replacement.size() - needle.size());
+      if (new_size <= capacity()) {
+        auto const source = mutable_data() + capacity() - size();
+        std::memmove(source, mutable_data(), size());
+        replace_all_into(mutable_data(), {source, size()}, needle, replacement);
+        set_size(new_size);
+        mutable_data()[new_size] = '\0';
+      } else {
+        char * it;
+        auto tmp = basic_jtstring{new_size, new_size, &it};
+        it = replace_all_into(it, view(), needle, replacement);
+        *it = '\0';
+        swap(*this, tmp);
+      }
+      return *this;
+    }
 
-    auto substr(std::size_t pos = 0, std::size_t count = npos) const -> jtstring {
+    auto substr(std::size_t pos = 0, std::size_t count = npos) const -> basic_jtstring {
       if (pos > size()) {
         throw std::out_of_range{"jtstring: substr pos out of range"};
       }
       auto const count2 = std::min(count, size() - pos);
       char * it;
-      auto ret = jtstring{count2, count2, &it};
+      auto ret = basic_jtstring{count2, count2, &it};
       it = std::copy(begin() + pos, begin() + pos + count2, it);
       *it = '\0';
       return ret;
@@ -429,18 +2428,18 @@ class jtstring {
     }
 
     void resize(std::size_t count, char ch) {
-      if (count <= capacity()) {
-        auto it = end();
-        for (; it < begin() + count; it += 1) {
+      if (count <= capacity() || try_grow_in_place(grown_capacity(count))) {
+        auto it = mutable_data() + size();
+        for (; it < cbegin() + count; it += 1) {
           *it = ch;
         }
         *it = '\0';
         set_size(count);
       } else {
         char * it;
-        auto tmp = jtstring{count, count, &it};
-        it = std::copy(begin(), begin() + std::min(count, size()), it);
-        for (; it < tmp.begin() + count; it += 1) {
+        auto tmp = basic_jtstring{count, grown_capacity(count), &it};
+        it = std::copy(cbegin(), cbegin() + std::min(count, size()), it);
+        for (; it < tmp.cbegin() + count; it += 1) {
           *it = ch;
         }
         *it = '\0';
@@ -452,8 +2451,20 @@ class jtstring {
       resize(count, char{});
     }
 
+    // As std::string's: makes room for `count` characters, keeping the current ones but leaving the rest uninitialised,
+    // then `op(data, count)` writes into the buffer and returns the new size, which must be at most `count`
+    template<typename Op>
+    void resize_and_overwrite(std::size_t count, Op op) {
+      if (count > capacity()) {
+        reserve(grown_capacity(count));
+      }
+      auto const new_size = static_cast<std::size_t>(std::move(op)(mutable_data(), count));
+      set_size(new_size);
+      mutable_data()[new_size] = '\0';
+    }
+
   private:
-    [[nodiscard]] static auto concat(std::initializer_list<std::string_view> views) -> jtstring { 
+    [[nodiscard]] static auto concat(std::initializer_list<std::string_view> views) -> basic_jtstring { 
       char * it;
 
       auto size = std::accumulate
@@ -465,7 +2476,7 @@ class jtstring {
           }
         );
 
-      auto ret = jtstring{size, size, &it};
+      auto ret = basic_jtstring{size, size, &it};
 
       for (auto view : views) {
         it = std::copy(view.begin(), view.end(), it);
@@ -475,78 +2486,718 @@ class jtstring {
       return ret;
     }
 
+    // The characters an argument of concat contributes: itself for strings and characters, its decimal digits for integers
+    template<typename T>
+    [[nodiscard]] static auto piece(T const & arg) noexcept {
+      if constexpr (std::is_same_v<T, char>) {
+        return std::string_view{&arg, 1};
+      } else if constexpr (std::integral<T>) {
+        static_assert(!std::is_same_v<T, bool>, "concat does not format bool");
+        return jtstring_digits{arg};
+      } else {
+        return std::string_view{arg};
+      }
+    }
+
   public:
-    [[nodiscard]] friend auto operator+(jtstring const & lhs, jtstring const & rhs) -> jtstring {
+    // Concatenates any mix of strings, string views, C strings, characters and integers into a string of exactly
+    // the total size, sized up front so that it is built with at most one allocation, or none if it fits inline
+    template<typename... Args>
+    [[nodiscard]] static auto concat(Args const &... args) -> basic_jtstring {
+      return concat({static_cast<std::string_view>(piece(args))...});
+    }
+
+    // Concatenates the elements of `range` with `separator` between each pair, in one allocation of the total size
+    template<std::ranges::forward_range Range>
+      requires std::convertible_to<std::ranges::range_reference_t<Range>, std::string_view>
+    [[nodiscard]] static auto join(std::string_view separator, Range && range) -> basic_jtstring {
+      auto size = std::size_t{0};
+      auto count = std::size_t{0};
+      for (std::string_view view : range) {
+        size += view.size();
+        count += 1;
+      }
+      size += count == 0 ? 0 : (count - 1) * separator.size();
+
+      char * it;
+      auto ret = basic_jtstring{size, size, &it};
+      auto first = true;
+      for (std::string_view view : range) {
+        if (!first) {
+          it = std::copy(separator.begin(), separator.end(), it);
+        }
+        first = false;
+        it = std::copy(view.begin(), view.end(), it);
+      }
+      *it = '\0';
+
+      return ret;
+    }
+
+    [[nodiscard]] friend auto operator+(basic_jtstring const & lhs, basic_jtstring const & rhs) -> basic_jtstring {
       return concat({lhs, rhs});
     }
 
-    [[nodiscard]] friend auto operator+(jtstring const & lhs, std::string_view rhs) -> jtstring {
+    [[nodiscard]] friend auto operator+(basic_jtstring const & lhs, std::string_view rhs) -> basic_jtstring {
       return concat({lhs, rhs});
     }
 
-    [[nodiscard]] friend auto operator+(std::string_view lhs, jtstring const & rhs) -> jtstring {
+    [[nodiscard]] friend auto operator+(std::string_view lhs, basic_jtstring const & rhs) -> basic_jtstring {
       return concat({lhs, rhs});
     }
 
-    [[nodiscard]] friend auto operator+(jtstring const & lhs, char rhs) -> jtstring {
+    [[nodiscard]] friend auto operator+(basic_jtstring const & lhs, char rhs) -> basic_jtstring {
       return lhs + std::string_view{&rhs, 1};
     }
 
-    [[nodiscard]] friend auto operator+(char lhs, jtstring const & rhs) -> jtstring {
+    [[nodiscard]] friend auto operator+(char lhs, basic_jtstring const & rhs) -> basic_jtstring {
       return std::string_view{&lhs, 1} + rhs;
     }
 
-    [[nodiscard]] friend auto operator+(jtstring&& lhs, jtstring const & rhs) -> jtstring {
+    [[nodiscard]] friend auto operator+(basic_jtstring&& lhs, basic_jtstring const & rhs) -> basic_jtstring {
       lhs.append(rhs);
       return std::move(lhs);
     }
 
-    [[nodiscard]] friend auto operator+(jtstring&& lhs, std::string_view rhs) -> jtstring {
+    // Both temporaries would otherwise match the two overloads above and below equally well
+    [[nodiscard]] friend auto operator+(basic_jtstring&& lhs, basic_jtstring&& rhs) -> basic_jtstring {
       lhs.append(rhs);
       return std::move(lhs);
     }
 
-    [[nodiscard]] friend auto operator+(std::string_view lhs, jtstring&& rhs) -> jtstring {
-      rhs.insert(rhs.begin(), lhs);
+    [[nodiscard]] friend auto operator+(basic_jtstring&& lhs, std::string_view rhs) -> basic_jtstring {
+      lhs.append(rhs);
+      return std::move(lhs);
+    }
+
+    [[nodiscard]] friend auto operator+(std::string_view lhs, basic_jtstring&& rhs) -> basic_jtstring {
+      rhs.insert(rhs.cbegin(), lhs);
       return std::move(rhs);
     }
 
-    [[nodiscard]] friend auto operator+(jtstring&& lhs, char rhs) -> jtstring {
+    [[nodiscard]] friend auto operator+(basic_jtstring&& lhs, char rhs) -> basic_jtstring {
       lhs.append(1, rhs);
       return std::move(lhs);
     }
 
-    [[nodiscard]] friend auto operator+(char lhs, jtstring&& rhs) -> jtstring {
-      rhs.insert(rhs.begin(), 1, lhs);
+    [[nodiscard]] friend auto operator+(char lhs, basic_jtstring&& rhs) -> basic_jtstring {
+      rhs.insert(rhs.cbegin(), 1, lhs);
       return std::move(rhs);
     }
 
-    [[nodiscard]] friend auto operator==(jtstring const & lhs, jtstring const & rhs) {
-      return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    [[nodiscard]] friend constexpr auto operator==(basic_jtstring const & lhs, basic_jtstring const & rhs) -> bool {
+      if (std::is_constant_evaluated()) {
+        return lhs.view() == rhs.view();
+      }
+      static_assert(!compact || (offsetof(jtstring_small, data) == 0 && offsetof(jtstring_small, remaining) == 31), "The tag byte is compared along with the characters");
+      auto const lhs_large = lhs.is_large();
+      auto const rhs_large = rhs.is_large();
+      if (compact && !lhs_large && !rhs_large) {
+        // Compares the tag bytes and the characters at once, ignoring whatever is after the end
+        auto const significant = std::uint32_t{0x7FFF'FFFF} >> lhs.small.remaining | std::uint32_t{1} << 31;
+        return (~jtstring_compare::equal_bytes_32(&lhs.small, &rhs.small) & significant) == 0;
+      } else if (lhs_large && rhs_large) {
+        auto const n = lhs.large.size;
+        if (n != rhs.large.size) {
+          return false;
+        } else if (n <= 31) {
+          return jtstring_compare::equal_31(lhs.large.data, rhs.large.data, n);
+        } else if (n >= 32 && n <= 64) {
+          return jtstring_compare::equal_32_to_64(lhs.large.data, rhs.large.data, n);
+        } else {
+          return lhs.large.data == rhs.large.data || jtstring_compare::equal(lhs.large.data, rhs.large.data, n);
+        }
+      } else {
+        auto const n = lhs.size();
+        return n == rhs.size() && (n <= 31 ? jtstring_compare::equal_31(lhs.data(), rhs.data(), n) : jtstring_compare::equal_exact(lhs.data(), rhs.data(), n));
+      }
     }
 
-    [[nodiscard]] friend auto operator==(jtstring const & lhs, std::string_view rhs) {
-      return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    [[nodiscard]] friend constexpr auto operator==(basic_jtstring const & lhs, std::string_view rhs) -> bool {
+      return lhs.size() == rhs.size() && jtstring_compare::equal_exact(lhs.data(), rhs.data(), rhs.size());
     }
 
-    [[nodiscard]] friend auto operator==(std::string_view lhs, jtstring const & rhs) {
-      return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    [[nodiscard]] friend constexpr auto operator==(std::string_view lhs, basic_jtstring const & rhs) -> bool {
+      return rhs == lhs;
     }
 
-    [[nodiscard]] friend auto operator<=>(jtstring const & lhs, jtstring const & rhs) -> std::weak_ordering {
+    [[nodiscard]] friend constexpr auto operator<=>(basic_jtstring const & lhs, basic_jtstring const & rhs) -> std::weak_ordering {
       return lhs.view() <=> rhs.view();
     }
 
-    [[nodiscard]] friend auto operator<=>(jtstring const & lhs, std::string_view rhs) -> std::weak_ordering {
+    [[nodiscard]] friend constexpr auto operator<=>(basic_jtstring const & lhs, std::string_view rhs) -> std::weak_ordering {
       return lhs.view() <=> rhs;
     }
 
-    [[nodiscard]] friend auto operator<=>(std::string_view lhs, jtstring const & rhs) -> std::weak_ordering {
+    [[nodiscard]] friend constexpr auto operator<=>(std::string_view lhs, basic_jtstring const & rhs) -> std::weak_ordering {
       return lhs <=> rhs.view();
     }
 
-    friend auto operator<<(std::basic_ostream<char>& os, jtstring const & str) -> std::basic_ostream<char> & {
+    friend auto operator<<(std::basic_ostream<char>& os, basic_jtstring const & str) -> std::basic_ostream<char> & {
       return os << str.view();
     }
 };
 
+// Transparent hasher, so that containers keyed on jtstring can be searched with a string_view without a conversion
+struct jtstring_hash {
+  using is_transparent = void;
+
+  [[nodiscard]] auto operator()(std::string_view sv) const noexcept -> std::size_t {
+    return jtstring_hashing::hash(sv.data(), sv.size());
+  }
+
+  [[nodiscard]] auto operator()(char const * str) const noexcept -> std::size_t {
+    return (*this)(std::string_view{str});
+  }
+
+  template<typename Alloc, typename Growth, jtstring_ownership Ownership, std::size_t InlineBytes>
+  [[nodiscard]] auto operator()(basic_jtstring<Alloc, Growth, Ownership, InlineBytes> const & str) const noexcept -> std::size_t {
+    return str.hash();
+  }
+};
+
+template<typename Alloc, typename Growth, jtstring_ownership Ownership, std::size_t InlineBytes>
+struct std::hash<basic_jtstring<Alloc, Growth, Ownership, InlineBytes>> {
+  [[nodiscard]] auto operator()(basic_jtstring<Alloc, Growth, Ownership, InlineBytes> const & str) const noexcept -> std::size_t {
+    return str.hash();
+  }
+};
+
+#if defined(__GLIBCXX__)
+// libstdc++ only stores hash codes in unordered containers for hashers it considers slow,
+// otherwise it rehashes every node it walks past; std::string's hasher opts out in the same way.
+// std::__is_fast_hash is a libstdc++ internal rather than a standard customisation point, hence the guard:
+// other standard libraries have no such trait and cache hash codes on their own terms
+template<>
+struct std::__is_fast_hash<jtstring_hash> : std::false_type {};
+
+template<typename Alloc, typename Growth, jtstring_ownership Ownership, std::size_t InlineBytes>
+struct std::__is_fast_hash<std::hash<basic_jtstring<Alloc, Growth, Ownership, InlineBytes>>> : std::false_type {};
+#endif
+
+#if defined(JTSTRING_HAS_FORMAT)
+// Appends to `out`, as std::format_to does to an output iterator
+template<typename Alloc, typename Growth, jtstring_ownership Ownership, std::size_t InlineBytes, typename... Args>
+auto format_to(basic_jtstring<Alloc, Growth, Ownership, InlineBytes> & out, jtstring_format_string<Args...> pattern, Args &&... args) -> basic_jtstring<Alloc, Growth, Ownership, InlineBytes> & {
+  return out.append_format(pattern, std::forward<Args>(args)...);
+}
+
+// Formats a jtstring argument as its string_view, so it takes the same format specs
+template<typename Alloc, typename Growth, jtstring_ownership Ownership, std::size_t InlineBytes>
+struct jtstring_format_backend::formatter<basic_jtstring<Alloc, Growth, Ownership, InlineBytes>, char> : jtstring_format_backend::formatter<std::string_view, char> {
+  template<typename FormatContext>
+  auto format(basic_jtstring<Alloc, Growth, Ownership, InlineBytes> const & str, FormatContext & ctx) const {
+    return jtstring_format_backend::formatter<std::string_view, char>::format(str.view(), ctx);
+  }
+};
+#endif
+
+using jtstring = basic_jtstring<>;
+
+using jtstring_pmr = basic_jtstring<jtstring_resource_allocator<char>>;
+
+using jtstring_malloc = basic_jtstring<jtstring_malloc_allocator<char>>;
+
+// Heap buffers of up to 256 bytes are cached per thread by jtstring_size_class_cache
+using jtstring_cached = basic_jtstring<jtstring_cached_allocator<char>>;
+
+// Heap buffers come from the thread's current jtstring_pool, for strings that die with the pool's next reset()
+using jtstring_pooled = basic_jtstring<jtstring_pool_allocator<char>>;
+
+// Copies of heap strings share their buffer until one of them is modified
+using jtstring_shared = basic_jtstring<std::allocator<char>, jtstring_growth_double, jtstring_ownership::shared>;
+
+// Keeps up to `InlineBytes` - 1 characters inline, for workloads such as paths whose strings mostly overflow 31 characters
+template<std::size_t InlineBytes>
+using jtstring_inline = basic_jtstring<std::allocator<char>, jtstring_growth_double, jtstring_ownership::unique, InlineBytes>;
+
+// "key"_jt, a constant expression when the literal fits inline
+[[nodiscard]] constexpr auto operator""_jt(char const * str, std::size_t size) -> jtstring {
+  return jtstring{std::string_view{str, size}};
+}
+
+// As std::to_string, but through std::to_chars, so floating point values get their shortest round trip representation
+template<typename T>
+  requires std::is_arithmetic_v<T>
+[[nodiscard]] auto to_jtstring(T value) -> jtstring {
+  auto str = jtstring{};
+  str.append_number(value);
+  return str;
+}
+
+class jtstring_interner;
+
+// A handle to a string interned by a jtstring_interner, valid for the interner's lifetime.
+// Handles of the same interner compare and hash in O(1): equal contents are the same entry, so the same pointer.
+// A default constructed handle refers to no string: it only compares and hashes, and must not be dereferenced.
+class jtstring_atom {
+  private:
+    struct entry {
+      jtstring str;
+      std::size_t hash;
+    };
+
+    entry const * target = nullptr;
+
+    explicit jtstring_atom(entry const * target) noexcept : target{target} {}
+
+    friend class jtstring_interner;
+
+  public:
+    jtstring_atom() noexcept = default;
+
+    [[nodiscard]] explicit operator bool() const noexcept { return target != nullptr; }
+
+    // str(), view() and hash() require a handle that refers to a string
+    [[nodiscard]] auto str() const noexcept -> jtstring const & { return target->str; }
+    [[nodiscard]] auto view() const noexcept -> std::string_view { return target->str.view(); }
+
+    // jtstring_hash of the contents, computed once when the string was interned
+    [[nodiscard]] auto hash() const noexcept -> std::size_t { return target->hash; }
+
+    [[nodiscard]] friend auto operator==(jtstring_atom lhs, jtstring_atom rhs) noexcept -> bool = default;
+};
+
+template<>
+struct std::hash<jtstring_atom> {
+  [[nodiscard]] auto operator()(jtstring_atom atom) const noexcept -> std::size_t {
+    // Null handles all hash alike, without a string to hash
+    return atom ? atom.hash() : 0;
+  }
+};
+
+// Deduplicates strings into jtstring_atom handles. Lookups of strings already interned are lock free and can run on
+// any number of threads; adding a string takes a lock. Strings are never removed, they live as long as the interner.
+//
+// The table is open addressed with linear probing over atomic pointers to the entries, and kept at most half full.
+// Growing publishes a new table and keeps the old ones until the interner is destroyed, so a reader still probing
+// an old table reads valid, if stale, slots; a miss there is settled under the lock against the current table.
+class jtstring_interner {
+  private:
+    using entry = jtstring_atom::entry;
+
+    struct table {
+      std::size_t mask;
+      std::unique_ptr<std::atomic<entry const *>[]> slots;
+
+      explicit table(std::size_t capacity)
+        : mask{capacity - 1}
+        , slots{std::make_unique<std::atomic<entry const *>[]>(capacity)}
+        {}
+    };
+
+    static constexpr auto min_capacity = std::size_t{64};
+
+    std::atomic<table *> current;
+    std::atomic<std::size_t> count{0};
+    // Only touched under `lock`. A deque never moves its elements, so readers can hold on to entries while it grows.
+    std::mutex lock;
+    std::deque<entry> entries;
+    std::vector<std::unique_ptr<table>> tables;
+
+    [[nodiscard]] static auto find_in(table const & t, std::string_view view, std::size_t hash) noexcept -> entry const * {
+      for (auto i = hash & t.mask;; i = (i + 1) & t.mask) {
+        auto const e = t.slots[i].load(std::memory_order_acquire);
+        if (e == nullptr || (e->hash == hash && e->str.view() == view)) {
+          return e;
+        }
+      }
+    }
+
+    static void place(table & t, entry const * e) noexcept {
+      auto i = e->hash & t.mask;
+      while (t.slots[i].load(std::memory_order_relaxed) != nullptr) {
+        i = (i + 1) & t.mask;
+      }
+      t.slots[i].store(e, std::memory_order_release);
+    }
+
+    // Makes room for `n` more entries. Called with the lock held.
+    void reserve_locked(std::size_t n) {
+      auto const old = current.load(std::memory_order_relaxed);
+      auto const needed = 2 * (count.load(std::memory_order_relaxed) + n);
+      if (needed <= old->mask + 1) {
+        return;
+      }
+      auto grown = std::make_unique<table>(std::bit_ceil(needed));
+      for (auto const & e : entries) {
+        place(*grown, &e);
+      }
+      current.store(grown.get(), std::memory_order_release);
+      tables.push_back(std::move(grown));
+    }
+
+    // Interns a string missed by a lock free lookup. Called with the lock held.
+    [[nodiscard]] auto insert_locked(std::string_view view, std::size_t hash) -> entry const * {
+      if (auto const e = find_in(*current.load(std::memory_order_relaxed), view, hash)) {
+        return e;
+      }
+      reserve_locked(1);
+      auto const & e = entries.emplace_back(jtstring{view}, hash);
+      place(*current.load(std::memory_order_relaxed), &e);
+      count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return &e;
+    }
+
+  public:
+    explicit jtstring_interner(std::size_t expected = 0) {
+      tables.push_back(std::make_unique<table>(std::max(min_capacity, std::bit_ceil(2 * expected))));
+      current.store(tables.back().get(), std::memory_order_relaxed);
+    }
+
+    jtstring_interner(jtstring_interner const &) = delete;
+    jtstring_interner& operator=(jtstring_interner const &) = delete;
+
+    // The handle of `view` if it has been interned, without taking the lock, otherwise a null handle
+    [[nodiscard]] auto find(std::string_view view) const noexcept -> jtstring_atom {
+      return jtstring_atom{find_in(*current.load(std::memory_order_acquire), view, jtstring_hash{}(view))};
+    }
+
+    [[nodiscard]] auto intern(std::string_view view) -> jtstring_atom {
+      return intern(view, jtstring_hash{}(view));
+    }
+
+    // Reuses the hash that `str` may have cached
+    [[nodiscard]] auto intern(jtstring const & str) -> jtstring_atom {
+      return intern(str.view(), str.hash());
+    }
+
+    // Interns `views` into the first handles of `out`, taking the lock at most once for all the strings not yet interned
+    void intern(std::span<std::string_view const> views, std::span<jtstring_atom> out) {
+      if (out.size() < views.size()) {
+        throw std::out_of_range{"jtstring: Fewer atoms than views"};
+      }
+
+      auto const t = current.load(std::memory_order_acquire);
+      auto missed = std::size_t{0};
+      for (auto i = std::size_t{0}; i < views.size(); i += 1) {
+        out[i] = jtstring_atom{find_in(*t, views[i], jtstring_hash{}(views[i]))};
+        missed += !out[i];
+      }
+      if (missed == 0) {
+        return;
+      }
+
+      auto const guard = std::lock_guard{lock};
+      reserve_locked(missed);
+      for (auto i = std::size_t{0}; i < views.size(); i += 1) {
+        if (!out[i]) {
+          out[i] = jtstring_atom{insert_locked(views[i], jtstring_hash{}(views[i]))};
+        }
+      }
+    }
+
+    // The number of distinct strings interned
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+      return count.load(std::memory_order_relaxed);
+    }
+
+  private:
+    [[nodiscard]] auto intern(std::string_view view, std::size_t hash) -> jtstring_atom {
+      if (auto const e = find_in(*current.load(std::memory_order_acquire), view, hash)) {
+        return jtstring_atom{e};
+      }
+      auto const guard = std::lock_guard{lock};
+      return jtstring_atom{insert_locked(view, hash)};
+    }
+};
+
+// A string for very large texts that are edited in place, kept as a balanced tree of jtstring chunks.
+// Insert, erase, substr and concatenation split and join the tree in O(log n) without touching the characters:
+// nodes are immutable and shared, so a substr or a copy of the rope shares its chunks with the original.
+// Leaves are slices of a chunk, and adjacent small leaves are merged while joining so that many small edits
+// do not fragment the text into single characters.
+class jtrope {
+  private:
+    struct node;
+    using node_ptr = std::shared_ptr<node const>;
+
+    struct node {
+      node_ptr left;
+      node_ptr right;
+      // A leaf is the characters [offset, offset + size) of `chunk`, which is never modified once shared
+      std::shared_ptr<jtstring> chunk;
+      std::size_t offset;
+      std::size_t size;
+      int height;
+
+      [[nodiscard]] auto is_leaf() const noexcept -> bool { return chunk != nullptr; }
+      [[nodiscard]] auto view() const noexcept -> std::string_view { return chunk->view().substr(offset, size); }
+    };
+
+    // Leaves that meet while joining are copied into one when they fit in this many bytes
+    static constexpr auto merge_limit = std::size_t{512};
+
+    node_ptr root;
+
+    explicit jtrope(node_ptr root) noexcept : root{std::move(root)} {}
+
+    [[nodiscard]] static auto leaf(std::shared_ptr<jtstring> chunk, std::size_t offset, std::size_t size) -> node_ptr {
+      if (size == 0) {
+        return nullptr;
+      }
+      return std::make_shared<node const>(node{nullptr, nullptr, std::move(chunk), offset, size, 0});
+    }
+
+    [[nodiscard]] static auto leaf(jtstring str) -> node_ptr {
+      auto const size = str.size();
+      return leaf(std::make_shared<jtstring>(std::move(str)), 0, size);
+    }
+
+    [[nodiscard]] static auto branch(node_ptr left, node_ptr right) -> node_ptr {
+      auto const size = left->size + right->size;
+      auto const height = 1 + std::max(left->height, right->height);
+      return std::make_shared<node const>(node{std::move(left), std::move(right), nullptr, 0, size, height});
+    }
+
+    // A node over `left` and `right`, whose heights differ by at most 2, rotated back into balance
+    [[nodiscard]] static auto balance(node_ptr left, node_ptr right) -> node_ptr {
+      if (left->height > right->height + 1) {
+        if (left->left->height >= left->right->height) {
+          return branch(left->left, branch(left->right, std::move(right)));
+        }
+        return branch(branch(left->left, left->right->left), branch(left->right->right, std::move(right)));
+      }
+      if (right->height > left->height + 1) {
+        if (right->right->height >= right->left->height) {
+          return branch(branch(std::move(left), right->left), right->right);
+        }
+        return branch(branch(std::move(left), right->left->left), branch(right->left->right, right->right));
+      }
+      return branch(std::move(left), std::move(right));
+    }
+
+    // The concatenation of two trees, in O(|height(lhs) - height(rhs)|)
+    [[nodiscard]] static auto join(node_ptr lhs, node_ptr rhs) -> node_ptr {
+      if (!lhs) {
+        return rhs;
+      }
+      if (!rhs) {
+        return lhs;
+      }
+      if (lhs->is_leaf() && rhs->is_leaf() && lhs->size + rhs->size <= merge_limit) {
+        auto str = jtstring{};
+        str.reserve(lhs->size + rhs->size);
+        str.append(lhs->view());
+        str.append(rhs->view());
+        return leaf(std::move(str));
+      }
+      if (lhs->height > rhs->height + 1) {
+        return balance(lhs->left, join(lhs->right, std::move(rhs)));
+      }
+      if (rhs->height > lhs->height + 1) {
+        return balance(join(std::move(lhs), rhs->left), rhs->right);
+      }
+      return branch(std::move(lhs), std::move(rhs));
+    }
+
+    // The first `pos` characters of `t` and the rest, in O(log n)
+    [[nodiscard]] static auto split(node_ptr const & t, std::size_t pos) -> std::pair<node_ptr, node_ptr> {
+      if (!t || pos == 0) {
+        return {nullptr, t};
+      }
+      if (pos >= t->size) {
+        return {t, nullptr};
+      }
+      if (t->is_leaf()) {
+        return {leaf(t->chunk, t->offset, pos), leaf(t->chunk, t->offset + pos, t->size - pos)};
+      }
+      if (pos <= t->left->size) {
+        auto [left, right] = split(t->left, pos);
+        return {std::move(left), join(std::move(right), t->right)};
+      }
+      auto [left, right] = split(t->right, pos - t->left->size);
+      return {join(t->left, std::move(left)), std::move(right)};
+    }
+
+    [[nodiscard]] auto split_checked(std::size_t pos, char const * what) const -> std::pair<node_ptr, node_ptr> {
+      if (pos > size()) {
+        throw std::out_of_range{what};
+      }
+      return split(root, pos);
+    }
+
+  public:
+    static constexpr auto npos = std::string_view::npos;
+
+    // Visits the chunks of a rope in order, as views into the rope's leaves
+    class chunk_iterator {
+      private:
+        std::vector<node const *> pending;
+        node const * current = nullptr;
+
+        void descend(node const * t) {
+          while (!t->is_leaf()) {
+            pending.push_back(t->right.get());
+            t = t->left.get();
+          }
+          current = t;
+        }
+
+        friend class jtrope;
+
+      public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+
+        chunk_iterator() noexcept = default;
+
+        [[nodiscard]] auto operator*() const noexcept -> std::string_view { return current->view(); }
+
+        auto operator++() -> chunk_iterator & {
+          if (pending.empty()) {
+            current = nullptr;
+          } else {
+            auto const next = pending.back();
+            pending.pop_back();
+            descend(next);
+          }
+          return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        [[nodiscard]] friend auto operator==(chunk_iterator const & it, std::default_sentinel_t) noexcept -> bool {
+          return it.current == nullptr;
+        }
+    };
+
+    jtrope() noexcept = default;
+
+    // Takes over the buffer of `str` without copying it
+    explicit jtrope(jtstring str) : root{leaf(std::move(str))} {}
+
+    explicit jtrope(std::string_view view) : jtrope{jtstring{view}} {}
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return root ? root->size : 0; }
+    [[nodiscard]] auto empty() const noexcept -> bool { return !root; }
+
+    [[nodiscard]] auto operator[](std::size_t pos) const noexcept -> char {
+      auto t = root.get();
+      while (!t->is_leaf()) {
+        if (pos < t->left->size) {
+          t = t->left.get();
+        } else {
+          pos -= t->left->size;
+          t = t->right.get();
+        }
+      }
+      return t->chunk->data()[t->offset + pos];
+    }
+
+    [[nodiscard]] auto at(std::size_t pos) const -> char {
+      if (pos >= size()) {
+        throw std::out_of_range{"jtrope: at pos out of range"};
+      }
+      return (*this)[pos];
+    }
+
+    [[nodiscard]] auto chunks() const -> std::ranges::subrange<chunk_iterator, std::default_sentinel_t> {
+      auto it = chunk_iterator{};
+      if (root) {
+        it.descend(root.get());
+      }
+      return {std::move(it), std::default_sentinel};
+    }
+
+    // The characters as one contiguous string
+    [[nodiscard]] auto str() const & -> jtstring {
+      auto result = jtstring{};
+      result.reserve(size());
+      for (auto const chunk : chunks()) {
+        result.append(chunk);
+      }
+      return result;
+    }
+
+    // Moves the chunk out when the rope is a single unshared chunk, as after jtrope{std::move(str)}
+    [[nodiscard]] auto str() && -> jtstring {
+      if (root && root->is_leaf() && root->offset == 0 && root->size == root->chunk->size() &&
+          root.use_count() == 1 && root->chunk.use_count() == 1) {
+        auto result = std::move(*root->chunk);
+        root = nullptr;
+        return result;
+      }
+      return str();
+    }
+
+    [[nodiscard]] auto substr(std::size_t pos, std::size_t count = npos) const -> jtrope {
+      auto [left, right] = split_checked(pos, "jtrope: substr pos out of range");
+      return jtrope{split(right, count).first};
+    }
+
+    auto insert(std::size_t pos, jtrope const & rope) -> jtrope & {
+      auto [left, right] = split_checked(pos, "jtrope: insert pos out of range");
+      root = join(join(std::move(left), rope.root), std::move(right));
+      return *this;
+    }
+
+    auto insert(std::size_t pos, std::string_view view) -> jtrope & {
+      auto [left, right] = split_checked(pos, "jtrope: insert pos out of range");
+      root = join(join(std::move(left), leaf(jtstring{view})), std::move(right));
+      return *this;
+    }
+
+    auto erase(std::size_t pos, std::size_t count = npos) -> jtrope & {
+      auto [left, right] = split_checked(pos, "jtrope: erase pos out of range");
+      root = join(std::move(left), split(right, count).second);
+      return *this;
+    }
+
+    auto append(jtrope const & rope) -> jtrope & {
+      root = join(std::move(root), rope.root);
+      return *this;
+    }
+
+    auto append(std::string_view view) -> jtrope & {
+      root = join(std::move(root), leaf(jtstring{view}));
+      return *this;
+    }
+
+    auto operator+=(jtrope const & rope) -> jtrope & { return append(rope); }
+    auto operator+=(std::string_view view) -> jtrope & { return append(view); }
+
+    [[nodiscard]] friend auto operator+(jtrope lhs, jtrope const & rhs) -> jtrope {
+      lhs.append(rhs);
+      return lhs;
+    }
+
+    // Compares chunk by chunk, whatever the chunk boundaries of either side
+    [[nodiscard]] friend auto operator==(jtrope const & lhs, jtrope const & rhs) -> bool {
+      if (lhs.size() != rhs.size()) {
+        return false;
+      }
+      auto rhs_chunks = rhs.chunks();
+      auto it = rhs_chunks.begin();
+      auto rest = std::string_view{};
+      for (auto chunk : lhs.chunks()) {
+        while (!chunk.empty()) {
+          if (rest.empty()) {
+            rest = *it;
+            ++it;
+          }
+          auto const n = std::min(chunk.size(), rest.size());
+          if (chunk.substr(0, n) != rest.substr(0, n)) {
+            return false;
+          }
+          chunk.remove_prefix(n);
+          rest.remove_prefix(n);
+        }
+      }
+      return true;
+    }
+
+    [[nodiscard]] friend auto operator==(jtrope const & lhs, std::string_view rhs) -> bool {
+      if (lhs.size() != rhs.size()) {
+        return false;
+      }
+      for (auto const chunk : lhs.chunks()) {
+        if (chunk != rhs.substr(0, chunk.size())) {
+          return false;
+        }
+        rhs.remove_prefix(chunk.size());
+      }
+      return true;
+    }
+};
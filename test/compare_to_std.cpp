@@ -3,10 +3,23 @@
 
 #include "jtstring.hpp"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <compare>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 using namespace std::literals;
 
@@ -19,6 +32,46 @@ namespace rc {
   };
 }
 
+auto replace_all(std::string s, std::string_view needle, std::string_view replacement) -> std::string {
+  if (!needle.empty()) {
+    for (auto pos = s.find(needle); pos != std::string::npos; pos = s.find(needle, pos + replacement.size())) {
+      s.replace(pos, needle.size(), replacement);
+    }
+  }
+  return s;
+}
+
+// Splits as jtstring's split ranges do, with lines ending in "\n" or "\r\n"
+auto split_all(std::string_view s, std::string_view delimiter, bool any, bool lines = false) -> std::vector<std::string_view> {
+  auto fields = std::vector<std::string_view>{};
+  if (lines && s.empty()) {
+    return fields;
+  }
+  for (auto first = std::size_t{0};;) {
+    auto const last = delimiter.empty() ? std::string_view::npos : any ? s.find_first_of(delimiter, first) : s.find(delimiter, first);
+    auto field = s.substr(first, last == std::string_view::npos ? std::string_view::npos : last - first);
+    if (lines && field.ends_with('\r')) {
+      field.remove_suffix(1);
+    }
+    fields.push_back(field);
+    if (last == std::string_view::npos || (lines && last + 1 == s.size())) {
+      return fields;
+    }
+    first = last + delimiter.size() * !any + any;
+  }
+}
+
+// Split fields are returned by value: a C++20 forward range, but only a Cpp17 input iterator
+using split_iterator = std::ranges::iterator_t<decltype(std::declval<jtstring const &>().split(','))>;
+static_assert(std::forward_iterator<split_iterator>);
+static_assert(std::is_same_v<std::iterator_traits<split_iterator>::iterator_category, std::input_iterator_tag>);
+
+// Built at compile time, so every use below is checked by the compiler as well as at run time
+constexpr auto constant_table = std::array{""_jt, "alpha"_jt, "beta"_jt, jtstring{"0123456789012345678901234567890"}};
+static_assert(constant_table[1] == "alpha"sv && constant_table[1] < constant_table[2]);
+static_assert(constant_table[3].size() == jtstring::inline_capacity && constant_table[3].starts_with("0123"));
+static_assert(constant_table[3].find("789") == 7 && constant_table[3].find('5', 10) == 15);
+
 auto tests(rc::Gen<std::string> strs) -> bool {
   auto results =
   { rc::check
@@ -469,6 +522,18 @@ auto tests(rc::Gen<std::string> strs) -> bool {
       }
     )
 
+  , rc::check
+    ( "starts_with(jtstring)"
+    , [&] {
+        auto const s1 = *strs;
+        auto const count = *rc::gen::inRange<std::size_t>(0, s1.size() + 1).as("count");
+        auto const s2 = *rc::gen::element(s1.substr(0, count), *strs).as("s2");
+        auto const jtstr1 = jtstring{s1};
+        auto const jtstr2 = jtstring{s2};
+        RC_ASSERT(jtstr1.starts_with(jtstr2) == s1.starts_with(s2));
+      }
+    )
+
   , rc::check
     ( "starts_with(ch)"
     , [&] {
@@ -531,6 +596,27 @@ auto tests(rc::Gen<std::string> strs) -> bool {
       }
     )
 
+  , rc::check
+    ( "operator==(sv), starts_with(sv), ends_with(sv) with one character changed"
+    , [&] {
+        auto const s = *strs;
+        auto const jtstr = jtstring{s};
+        // The view ends its allocation, so reading past it would be caught
+        auto const copy = std::make_unique<char[]>(s.size());
+        std::copy(s.begin(), s.end(), copy.get());
+        auto const sv = std::string_view{copy.get(), s.size()};
+        RC_ASSERT(jtstr == sv);
+        RC_ASSERT(jtstr.starts_with(sv));
+        RC_ASSERT(jtstr.ends_with(sv));
+        if (!s.empty()) {
+          copy[*rc::gen::inRange<std::size_t>(0, s.size())] ^= 1;
+          RC_ASSERT(jtstr != sv);
+          RC_ASSERT(!jtstr.starts_with(sv));
+          RC_ASSERT(!jtstr.ends_with(sv));
+        }
+      }
+    )
+
   , rc::check
     ( "ends_with(ch)"
     , [&] {
@@ -583,6 +669,254 @@ auto tests(rc::Gen<std::string> strs) -> bool {
       }
     )
 
+  , rc::check
+    ( "find(sv, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const begin = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("begin");
+        auto const count = *rc::gen::inRange<std::size_t>(0, s.size() - begin + 1).as("count");
+        auto const needle = *rc::gen::element(s.substr(begin, count), *strs).as("needle");
+        auto const pos = *rc::gen::inRange<std::size_t>(0, s.size() + 2).as("pos");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.find(needle, pos) == s.find(needle, pos));
+      }
+    )
+
+  , rc::check
+    ( "find(ch, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto const pos = *rc::gen::inRange<std::size_t>(0, s.size() + 2).as("pos");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.find(ch, pos) == s.find(ch, pos));
+        for (auto c : s) {
+          RC_ASSERT(jtstr.find(c, pos) == s.find(c, pos));
+        }
+      }
+    )
+
+  , rc::check
+    ( "rfind(sv, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const begin = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("begin");
+        auto const count = *rc::gen::inRange<std::size_t>(0, s.size() - begin + 1).as("count");
+        auto const needle = *rc::gen::element(s.substr(begin, count), *strs).as("needle");
+        auto const pos = *rc::gen::element(std::string::npos, *rc::gen::inRange<std::size_t>(0, s.size() + 2)).as("pos");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.rfind(needle, pos) == s.rfind(needle, pos));
+      }
+    )
+
+  , rc::check
+    ( "rfind(ch, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const pos = *rc::gen::element(std::string::npos, *rc::gen::inRange<std::size_t>(0, s.size() + 2)).as("pos");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.rfind('\0', pos) == s.rfind('\0', pos));
+        for (auto c : s) {
+          RC_ASSERT(jtstr.rfind(c, pos) == s.rfind(c, pos));
+        }
+      }
+    )
+
+  , rc::check
+    ( "find_first_of(sv, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const set = *strs;
+        auto const pos = *rc::gen::inRange<std::size_t>(0, s.size() + 2).as("pos");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.find_first_of(set, pos) == s.find_first_of(set, pos));
+        RC_ASSERT(jtstr.find_first_of(set.substr(0, 4), pos) == s.find_first_of(set.substr(0, 4), pos));
+      }
+    )
+
+  , rc::check
+    ( "find_last_of(sv, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const set = *strs;
+        auto const pos = *rc::gen::element(std::string::npos, *rc::gen::inRange<std::size_t>(0, s.size() + 2)).as("pos");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.find_last_of(set, pos) == s.find_last_of(set, pos));
+        RC_ASSERT(jtstr.find_last_of(set.substr(0, 4), pos) == s.find_last_of(set.substr(0, 4), pos));
+      }
+    )
+
+  , rc::check
+    ( "find_first_not_of(sv, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const set = *rc::gen::element(s, *strs, s.substr(0, s.size() / 2)).as("set");
+        auto const pos = *rc::gen::inRange<std::size_t>(0, s.size() + 2).as("pos");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.find_first_not_of(set, pos) == s.find_first_not_of(set, pos));
+        RC_ASSERT(jtstr.find_first_not_of(set.substr(0, 4), pos) == s.find_first_not_of(set.substr(0, 4), pos));
+      }
+    )
+
+  , rc::check
+    ( "find_first_not_of(ch, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const pos = *rc::gen::inRange<std::size_t>(0, s.size() + 2).as("pos");
+        auto const jtstr = jtstring{s};
+        for (auto c : s) {
+          RC_ASSERT(jtstr.find_first_not_of(c, pos) == s.find_first_not_of(c, pos));
+        }
+      }
+    )
+
+  , rc::check
+    ( "find_last_not_of(sv, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const set = *rc::gen::element(s, *strs, s.substr(s.size() / 2)).as("set");
+        auto const pos = *rc::gen::element(std::string::npos, *rc::gen::inRange<std::size_t>(0, s.size() + 2)).as("pos");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.find_last_not_of(set, pos) == s.find_last_not_of(set, pos));
+        RC_ASSERT(jtstr.find_last_not_of(set.substr(0, 4), pos) == s.find_last_not_of(set.substr(0, 4), pos));
+      }
+    )
+
+  , rc::check
+    ( "find_last_not_of(ch, pos)"
+    , [&] {
+        auto const s = *strs;
+        auto const pos = *rc::gen::element(std::string::npos, *rc::gen::inRange<std::size_t>(0, s.size() + 2)).as("pos");
+        auto const jtstr = jtstring{s};
+        for (auto c : s) {
+          RC_ASSERT(jtstr.find_last_not_of(c, pos) == s.find_last_not_of(c, pos));
+        }
+      }
+    )
+
+  , rc::check
+    ( "contains(sv)"
+    , [&] {
+        auto const s = *strs;
+        auto const begin = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("begin");
+        auto const count = *rc::gen::inRange<std::size_t>(0, s.size() - begin + 1).as("count");
+        auto const needle = *rc::gen::element(s.substr(begin, count), *strs).as("needle");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.contains(needle) == (s.find(needle) != std::string::npos));
+        RC_ASSERT(jtstr.contains(needle.c_str()) == (s.find(needle.c_str()) != std::string::npos));
+      }
+    )
+
+  , rc::check
+    ( "contains(ch)"
+    , [&] {
+        auto const s = *strs;
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto const jtstr = jtstring{s};
+        RC_ASSERT(jtstr.contains(ch) == (s.find(ch) != std::string::npos));
+      }
+    )
+
+  , rc::check
+    ( "replace(pos, count, sv)"
+    , [&] {
+        auto s1 = *strs;
+        auto const pos = *rc::gen::inRange<std::size_t>(0, s1.size() + 1).as("pos");
+        auto const count = *rc::gen::arbitrary<std::size_t>().as("count");
+        auto const s2 = *strs;
+        auto jtstr = jtstring{s1};
+        s1.replace(pos, count, s2);
+        jtstr.replace(pos, count, s2);
+        RC_ASSERT(jtstr == s1);
+      }
+    )
+
+  , rc::check
+    ( "replace(first, last, sv)"
+    , [&] {
+        auto s1 = *strs;
+        auto const first = *rc::gen::inRange<std::size_t>(0, s1.size() + 1).as("first");
+        auto const last = *rc::gen::inRange<std::size_t>(first, s1.size() + 1).as("last");
+        auto const s2 = *strs;
+        auto jtstr = jtstring{s1};
+        s1.replace(s1.begin() + first, s1.begin() + last, s2);
+        jtstr.replace(jtstr.begin() + first, jtstr.begin() + last, s2);
+        RC_ASSERT(jtstr == s1);
+      }
+    )
+
+  , rc::check
+    ( "replace(pos, count, sv) from self"
+    , [&] {
+        auto s = *strs;
+        auto const pos = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("pos");
+        auto const count = *rc::gen::arbitrary<std::size_t>().as("count");
+        auto const begin = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("begin");
+        auto const length = *rc::gen::inRange<std::size_t>(0, s.size() - begin + 1).as("length");
+        auto jtstr = jtstring{s};
+        jtstr.reserve(s.size() * 2);
+        s.replace(pos, count, s.substr(begin, length));
+        jtstr.replace(pos, count, jtstr.view().substr(begin, length));
+        RC_ASSERT(jtstr == s);
+      }
+    )
+
+  , rc::check
+    ( "replace(pos, count, count2, ch)"
+    , [&] {
+        auto s = *strs;
+        auto const pos = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("pos");
+        auto const count = *rc::gen::arbitrary<std::size_t>().as("count");
+        auto const count2 = *rc::gen::withSize([](int size) { return rc::gen::inRange<std::size_t>(0, size); }).as("count2");
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto jtstr = jtstring{s};
+        s.replace(pos, count, count2, ch);
+        jtstr.replace(pos, count, count2, ch);
+        RC_ASSERT(jtstr == s);
+      }
+    )
+
+  , rc::check
+    ( "replace(first, last, count2, ch)"
+    , [&] {
+        auto s = *strs;
+        auto const first = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("first");
+        auto const last = *rc::gen::inRange<std::size_t>(first, s.size() + 1).as("last");
+        auto const count2 = *rc::gen::withSize([](int size) { return rc::gen::inRange<std::size_t>(0, size); }).as("count2");
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto jtstr = jtstring{s};
+        s.replace(s.begin() + first, s.begin() + last, count2, ch);
+        jtstr.replace(jtstr.begin() + first, jtstr.begin() + last, count2, ch);
+        RC_ASSERT(jtstr == s);
+      }
+    )
+
+  , rc::check
+    ( "replace_all(needle, replacement)"
+    , [&] {
+        auto const s = *rc::gen::container<std::string>(rc::gen::element('a', 'b', 'c')).as("s");
+        auto const needle = *rc::gen::container<std::string>(rc::gen::element('a', 'b')).as("needle");
+        auto const replacement = *rc::gen::container<std::string>(rc::gen::element('x', 'y')).as("replacement");
+        auto const spare = *rc::gen::withSize([](int size) { return rc::gen::inRange<std::size_t>(0, size); }).as("spare");
+        auto jtstr = jtstring{s};
+        jtstr.reserve(s.size() + spare);
+        jtstr.replace_all(needle, replacement);
+        RC_ASSERT(jtstr == replace_all(s, needle, replacement));
+      }
+    )
+
+  , rc::check
+    ( "replace_all(needle, replacement) from self"
+    , [&] {
+        auto const s = *rc::gen::container<std::string>(rc::gen::element('a', 'b')).as("s");
+        auto const begin = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("begin");
+        auto const length = *rc::gen::inRange<std::size_t>(0, s.size() - begin + 1).as("length");
+        auto jtstr = jtstring{s};
+        jtstr.replace_all(jtstr.view().substr(begin, length), jtstr.view());
+        RC_ASSERT(jtstr == replace_all(s, s.substr(begin, length), s));
+      }
+    )
+
   , rc::check
     ( "substr(pos, count)"
     , [&] {
@@ -622,6 +956,66 @@ auto tests(rc::Gen<std::string> strs) -> bool {
       }
     )
 
+  , rc::check
+    ( "from_views(views, out)"
+    , [&] {
+        auto const strings = *rc::gen::container<std::vector<std::string>>(strs);
+        auto const suffix = *strs;
+        auto const views = std::vector<std::string_view>(strings.begin(), strings.end());
+        auto jtstrs = std::vector<jtstring>(views.size(), jtstring{suffix});
+        jtstring::from_views(views, jtstrs);
+        auto const view_of = [](auto const & str) { return str.view(); };
+        RC_ASSERT(std::ranges::equal(jtstrs, views, {}, view_of));
+        for (auto i = std::size_t{0}; i < jtstrs.size(); i += 2) {
+          jtstrs[i] += suffix;
+          RC_ASSERT(jtstrs[i] == strings[i] + suffix);
+        }
+
+        // Rebuilds every string in place from a slice of itself
+        auto const skip = *rc::gen::inRange<std::size_t>(0, 40);
+        auto slices = std::vector<std::string_view>{};
+        auto expected = std::vector<std::string>{};
+        for (auto const & str : jtstrs) {
+          slices.push_back(str.view().substr(std::min(skip, str.size())));
+          expected.emplace_back(slices.back());
+        }
+        jtstring::from_views(slices, jtstrs);
+        RC_ASSERT(std::ranges::equal(jtstrs, expected, {}, view_of));
+
+        if (!jtstrs.empty()) {
+          auto const expected = std::string{jtstrs.back().view()};
+          auto const released = jtstrs.back().release();
+          RC_ASSERT(std::string_view{released.data.get(), released.size} == expected);
+          jtstrs.erase(jtstrs.begin());
+        }
+        auto shared = std::vector<jtstring_shared>(views.size());
+        jtstring_shared::from_views(views, shared);
+        RC_ASSERT(std::ranges::equal(shared, views, {}, view_of));
+      }
+    )
+
+  , rc::check
+    ( "resize_and_overwrite(count, op)"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto const count = *rc::gen::inRange<std::size_t>(0, s1.size() + s2.size() + 1);
+        auto const written = *rc::gen::inRange<std::size_t>(0, count + 1);
+        auto jtstr = jtstring{s1};
+        jtstr.resize_and_overwrite(count, [&](char * data, std::size_t n) {
+          RC_ASSERT(n == count);
+          RC_ASSERT(std::string_view{data, std::min(s1.size(), n)} == std::string_view{s1}.substr(0, n));
+          auto const from = std::min(s1.size(), written);
+          std::copy_n(s2.begin(), std::min(s2.size(), written - from), data + from);
+          std::fill(data + std::min(written, from + s2.size()), data + written, 'x');
+          return written;
+        });
+        auto expected = s1.substr(0, written) + s2;
+        expected.resize(written, 'x');
+        RC_ASSERT(jtstr == expected);
+      }
+    )
+
   , rc::check
     ( "resize(count)"
     , [&] {
@@ -634,6 +1028,172 @@ auto tests(rc::Gen<std::string> strs) -> bool {
       }
     )
 
+  , rc::check
+    ( "resize(size() + 1) loop"
+    , [&] {
+        auto s = *strs;
+        auto const count = *rc::gen::withSize([](int size) { return rc::gen::inRange<std::size_t>(0, size); }).as("count");
+        auto jtstr = jtstring{s};
+        for (auto i = std::size_t{0}; i < count; i += 1) {
+          s.resize(s.size() + 1, 'x');
+          jtstr.resize(jtstr.size() + 1, 'x');
+        }
+        RC_ASSERT(jtstr == s);
+      }
+    )
+
+  , rc::check
+    ( "push_back(ch) loop, 1.5x growth"
+    , [&] {
+        auto s = *strs;
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto jtstr = basic_jtstring<std::allocator<char>, jtstring_growth_one_and_half>{s};
+        for (auto i = 0; i < 64; i += 1) {
+          s.push_back(ch);
+          jtstr.push_back(ch);
+        }
+        RC_ASSERT(jtstr == s);
+      }
+    )
+
+  , rc::check
+    ( "append(sv) loop, size class growth"
+    , [&] {
+        auto s1 = *strs;
+        auto const s2 = *strs;
+        auto jtstr = basic_jtstring<std::allocator<char>, jtstring_growth_size_class>{s1};
+        for (auto i = 0; i < 8; i += 1) {
+          s1.append(s2);
+          jtstr.append(s2);
+          RC_ASSERT(jtstr.capacity() >= jtstr.size());
+        }
+        RC_ASSERT(jtstr == s1);
+      }
+    )
+
+  , rc::check
+    ( "concat(args...)"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto const s3 = *strs;
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto const i = *rc::gen::arbitrary<long long>().as("i");
+        auto const u = *rc::gen::arbitrary<unsigned>().as("u");
+        auto const jtstr = jtstring::concat(jtstring{s1}, std::string_view{s2}, ch, s3.c_str(), i, u);
+        RC_ASSERT(jtstr == s1 + s2 + ch + s3 + std::to_string(i) + std::to_string(u));
+        RC_ASSERT(jtstr.size() > jtstring::inline_capacity || jtstr.capacity() == jtstring::inline_capacity);
+        RC_ASSERT(jtstr.size() <= jtstring::inline_capacity || jtstr.capacity() == jtstr.size());
+      }
+    )
+
+  , rc::check
+    ( "append_number(integer)"
+    , [&] {
+        auto s = *strs;
+        auto const i = *rc::gen::arbitrary<long long>().as("i");
+        auto const u = *rc::gen::arbitrary<unsigned>().as("u");
+        auto jtstr = jtstring{s};
+        jtstr.append_number(i).append_number(u, 16).append_number(i, 2);
+        auto digits = std::array<char, 66>{};
+        s += std::to_string(i);
+        s.append(digits.data(), std::to_chars(digits.data(), digits.data() + digits.size(), u, 16).ptr);
+        s.append(digits.data(), std::to_chars(digits.data(), digits.data() + digits.size(), i, 2).ptr);
+        RC_ASSERT(jtstr == s);
+        RC_ASSERT(to_jtstring(i) == std::to_string(i));
+      }
+    )
+
+  , rc::check
+    ( "append_number(floating point)"
+    , [&] {
+        auto s = *strs;
+        auto const d = *rc::gen::arbitrary<double>().as("d");
+        auto const precision = *rc::gen::inRange(0, 400);
+        auto jtstr = jtstring{s};
+        jtstr.append_number(d).append_number(d, std::chars_format::fixed, precision);
+        auto digits = std::array<char, 1024>{};
+        s.append(digits.data(), std::to_chars(digits.data(), digits.data() + digits.size(), d).ptr);
+        s.append(digits.data(), std::to_chars(digits.data(), digits.data() + digits.size(), d, std::chars_format::fixed, precision).ptr);
+        RC_ASSERT(jtstr == s);
+
+        // The longest shortest round trips, with a prefix leaving any amount of spare inline capacity
+        auto const prefix = std::string(*rc::gen::inRange<std::size_t>(0, 32), 'x');
+        for (auto const x : {-std::numeric_limits<long double>::denorm_min(), -std::numeric_limits<long double>::max()}) {
+          auto expected = prefix;
+          expected.append(digits.data(), std::to_chars(digits.data(), digits.data() + digits.size(), x).ptr);
+          RC_ASSERT(jtstring{prefix}.append_number(x) == expected);
+        }
+      }
+    )
+
+#if defined(JTSTRING_HAS_FORMAT)
+  , rc::check
+    ( "format(pattern, args...)"
+    , [&] {
+        auto s = *strs;
+        auto const arg = *strs;
+        auto const i = *rc::gen::arbitrary<int>().as("i");
+        auto const width = *rc::gen::inRange(0, 100);
+        auto jtstr = jtstring{s};
+        format_to(jtstr, "{} {:>{}} {:#x}", jtstring{arg}, arg, width, i);
+        s += jtstring_format_backend::format("{} {:>{}} {:#x}", arg, arg, width, i);
+        RC_ASSERT(jtstr == s);
+        RC_ASSERT(jtstring::format("{}|{:.3}", arg, 0.5) == jtstring_format_backend::format("{}|{:.3}", arg, 0.5));
+      }
+    )
+#endif
+
+  , rc::check
+    ( "split(delimiter)"
+    , [&] {
+        auto const text = *strs + *rc::gen::container<std::string>(rc::gen::element('a', 'b', ',', ';')) + *strs;
+        auto const ch = *rc::gen::element(',', ';', 'a', ' ');
+        auto const delimiter = *rc::gen::element<std::string>("", ",", ";,", "aa", "a;b");
+        auto const jtstr = jtstring{text};
+        RC_ASSERT(std::ranges::equal(jtstr.split(ch), split_all(text, {&ch, 1}, false)));
+        RC_ASSERT(std::ranges::equal(jtstr.split(delimiter), split_all(text, delimiter, false)));
+      }
+    )
+
+  , rc::check
+    ( "split_any(delimiters)"
+    , [&] {
+        auto const text = *rc::gen::container<std::string>(rc::gen::element('a', 'b', ',', ';', ' ')) + *strs;
+        auto const delimiters = *rc::gen::element<std::string>("", ",", ";, ", "abcdefghijklmnopqrstuvwxyz");
+        auto const jtstr = jtstring{text};
+        RC_ASSERT(std::ranges::equal(jtstr.split_any(delimiters), split_all(text, delimiters, true)));
+        auto non_empty = std::vector<std::string_view>{};
+        std::ranges::copy(jtstr.split_any(delimiters) | std::views::filter([](auto field) { return !field.empty(); }), std::back_inserter(non_empty));
+        RC_ASSERT(std::ranges::equal(non_empty, split_all(text, delimiters, true) | std::views::filter([](auto field) { return !field.empty(); })));
+      }
+    )
+
+  , rc::check
+    ( "lines()"
+    , [&] {
+        auto const text = *rc::gen::container<std::string>(rc::gen::element('a', 'b', '\r', '\n')) + *strs + *rc::gen::element<std::string>("", "\n", "\r\n");
+        auto const jtstr = jtstring{text};
+        RC_ASSERT(std::ranges::equal(jtstr.lines(), split_all(text, "\n", false, true)));
+      }
+    )
+
+  , rc::check
+    ( "join(separator, range)"
+    , [&] {
+        auto const separator = *strs;
+        auto const strings = *rc::gen::container<std::vector<std::string>>(rc::gen::string<std::string>());
+        auto expected = std::string{};
+        for (auto const & s : strings) {
+          if (&s != &strings.front()) {
+            expected += separator;
+          }
+          expected += s;
+        }
+        RC_ASSERT(jtstring::join(separator, strings) == expected);
+      }
+    )
+
   , rc::check
     ( "operator+(s, s)"
     , [&] {
@@ -642,6 +1202,7 @@ auto tests(rc::Gen<std::string> strs) -> bool {
         auto jtstr1 = jtstring{s1};
         auto jtstr2 = jtstring{s2};
         RC_ASSERT((jtstr1 + jtstr2) == s1 + s2);
+        RC_ASSERT((jtstring{s1} + jtstring{s2}) == s1 + s2);
       }
     )
 
@@ -747,6 +1308,252 @@ auto tests(rc::Gen<std::string> strs) -> bool {
       }
     )
 
+  , rc::check
+    ( "operator==(s, s) small and large"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *rc::gen::element(s1, *strs).as("s2");
+        auto const jtstr1 = jtstring{s1};
+        auto jtstr2 = jtstring{s2};
+        jtstr2.reserve(64);
+        RC_ASSERT((jtstr1 == jtstr2) == (s1 == s2));
+        RC_ASSERT((jtstr2 == jtstr1) == (s1 == s2));
+      }
+    )
+
+  , rc::check
+    ( "operator==(s, s) after erase"
+    , [&] {
+        auto const s = *strs;
+        auto const index = *rc::gen::inRange<std::size_t>(0, s.size() + 1).as("index");
+        auto jtstr1 = jtstring{s};
+        auto const jtstr2 = jtstring{s.substr(0, index)};
+        jtstr1.erase(index);
+        RC_ASSERT(jtstr1 == jtstr2);
+      }
+    )
+
+  , rc::check
+    ( "full small string"
+    , [&] {
+        auto s = *strs;
+        s.resize(jtstring::inline_capacity, 'x');
+        auto jtstr = jtstring{};
+        for (auto ch : s) {
+          jtstr.push_back(ch);
+        }
+        RC_ASSERT(jtstr == s);
+        RC_ASSERT(jtstr == jtstring{s});
+        RC_ASSERT(jtstr.capacity() == jtstring::inline_capacity);
+        RC_ASSERT(jtstr.c_str()[jtstr.size()] == '\0');
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+        jtstr.pop_back();
+        RC_ASSERT(jtstr == s.substr(0, s.size() - 1));
+        RC_ASSERT(jtstr.c_str()[jtstr.size()] == '\0');
+        jtstr.append(1, s.back());
+        RC_ASSERT(jtstr == s);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_inline<InlineBytes>"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto const check = [&]<typename S>(S const &) {
+          auto jtstr = S{s1};
+          jtstr.append(s2);
+          jtstr.push_back(ch);
+          auto const s = s1 + s2 + ch;
+          RC_ASSERT(jtstr == s);
+          RC_ASSERT(jtstr == S{s});
+          RC_ASSERT(jtstr.c_str()[jtstr.size()] == '\0');
+          RC_ASSERT(jtstr.size() > S::inline_capacity || jtstr.capacity() == S::inline_capacity);
+          RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+          RC_ASSERT(jtstr.find(ch) == s.find(ch));
+          RC_ASSERT(jtstr.rfind(ch) == s.rfind(ch));
+          jtstr.erase(s1.size(), s2.size());
+          RC_ASSERT(jtstr == s1 + ch);
+        };
+        check(jtstring_inline<64>{});
+        check(jtstring_inline<128>{});
+      }
+    )
+
+  , rc::check
+    ( "constexpr table"
+    , [&] {
+        auto const s = *strs;
+        auto const jtstr = jtstring{s};
+        for (auto const & constant : constant_table) {
+          auto const c = std::string{constant.view()};
+          RC_ASSERT(constant == jtstring{c});
+          RC_ASSERT(constant.c_str()[constant.size()] == '\0');
+          RC_ASSERT((constant == jtstr) == (c == s));
+          RC_ASSERT((constant <=> jtstr) == (c <=> s));
+          RC_ASSERT(constant.starts_with(jtstr) == c.starts_with(s));
+          RC_ASSERT(constant.find(s) == c.find(s));
+        }
+      }
+    )
+
+  , rc::check
+    ( "jtstring_interner"
+    , [&] {
+        auto const strings = *rc::gen::container<std::vector<std::string>>(rc::gen::element(*strs, *strs, *strs)).as("strings");
+        auto interner = jtstring_interner{};
+        auto atoms = std::vector<jtstring_atom>{};
+        for (auto const & s : strings) {
+          atoms.push_back(interner.intern(s));
+          RC_ASSERT(atoms.back().view() == s);
+          RC_ASSERT(atoms.back().hash() == jtstring_hash{}(std::string_view{s}));
+          RC_ASSERT(interner.find(s) == atoms.back());
+          RC_ASSERT(interner.intern(jtstring{s}) == atoms.back());
+        }
+        for (auto i = std::size_t{0}; i < atoms.size(); i += 1) {
+          for (auto j = std::size_t{0}; j < atoms.size(); j += 1) {
+            RC_ASSERT((atoms[i] == atoms[j]) == (strings[i] == strings[j]));
+          }
+        }
+        RC_ASSERT(interner.size() == std::unordered_set<std::string>(strings.begin(), strings.end()).size());
+
+        auto views = std::vector<std::string_view>(strings.begin(), strings.end());
+        auto const extra = *strs + "!";
+        views.push_back(extra);
+        auto bulk = std::vector<jtstring_atom>(views.size());
+        interner.intern(views, bulk);
+        RC_ASSERT(std::equal(atoms.begin(), atoms.end(), bulk.begin()));
+        RC_ASSERT(bulk.back().view() == extra);
+        RC_ASSERT(interner.find(extra) == bulk.back());
+
+        RC_ASSERT(!interner.find(extra + "!"));
+        RC_ASSERT(std::hash<jtstring_atom>{}(jtstring_atom{}) == std::hash<jtstring_atom>{}(interner.find(extra + "!")));
+      }
+    )
+
+  , rc::check
+    ( "jtstring_interner lookups while another thread grows the table"
+    , [&] {
+        auto strings = *rc::gen::container<std::vector<std::string>>(rc::gen::element(*strs, *strs, *strs)).as("strings");
+        strings.push_back(*strs);
+        auto interner = jtstring_interner{};
+        auto atoms = std::vector<jtstring_atom>{};
+        for (auto const & s : strings) {
+          atoms.push_back(interner.intern(s));
+        }
+
+        // Enough new strings to grow the table from its minimum capacity several times over
+        auto const added = std::size_t{1024};
+        auto const name = [&](std::size_t i) { return strings[i % strings.size()] + "#" + std::to_string(i); };
+        auto const writer = [&] {
+          for (auto i = std::size_t{0}; i < added; i += 1) {
+            auto const atom = interner.intern(name(i));
+            RC_ASSERT(atom.view() == name(i));
+          }
+        };
+        auto const reader = [&] {
+          for (auto round = 0; round < 64; round += 1) {
+            for (auto i = std::size_t{0}; i < strings.size(); i += 1) {
+              RC_ASSERT(interner.find(strings[i]) == atoms[i]);
+              RC_ASSERT(interner.intern(strings[i]) == atoms[i]);
+            }
+          }
+        };
+        auto threads = std::vector<std::thread>{};
+        threads.emplace_back(writer);
+        threads.emplace_back(reader);
+        threads.emplace_back(reader);
+        for (auto & thread : threads) {
+          thread.join();
+        }
+        auto distinct = std::unordered_set<std::string>(strings.begin(), strings.end());
+        for (auto i = std::size_t{0}; i < added; i += 1) {
+          distinct.insert(name(i));
+        }
+        RC_ASSERT(interner.size() == distinct.size());
+      }
+    )
+
+  , rc::check
+    ( "jtrope"
+    , [&] {
+        auto expected = *strs;
+        auto rope = jtrope{jtstring{expected}};
+        auto const edits = *rc::gen::inRange(0, 40).as("edits");
+        for (auto i = 0; i < edits; i += 1) {
+          // Repeat some texts past the leaf merge limit so the tree grows
+          auto text = *strs;
+          for (auto r = *rc::gen::inRange(0, 3); r > 0; r -= 1) {
+            text += text + text + text;
+          }
+          auto const pos = *rc::gen::inRange<std::size_t>(0, expected.size() + 1);
+          auto const count = *rc::gen::inRange<std::size_t>(0, expected.size() - pos + 2);
+          switch (*rc::gen::inRange(0, 5)) {
+            case 0:
+              expected.insert(pos, text);
+              rope.insert(pos, text);
+              break;
+            case 1:
+              expected.erase(pos, count);
+              rope.erase(pos, count);
+              break;
+            case 2:
+              expected.append(text);
+              rope += text;
+              break;
+            case 3: {
+              auto const sub = rope.substr(pos, count);
+              RC_ASSERT(sub == std::string_view{expected}.substr(pos, count));
+              expected.insert(pos, expected.substr(pos, count));
+              rope.insert(pos, sub);
+              break;
+            }
+            default:
+              if (expected.size() < 4096) {
+                expected = expected + expected;
+                rope = rope + rope;
+              }
+              break;
+          }
+          RC_ASSERT(rope.size() == expected.size());
+          RC_ASSERT(rope == std::string_view{expected});
+        }
+
+        auto joined = std::string{};
+        for (auto const chunk : rope.chunks()) {
+          RC_ASSERT(!chunk.empty());
+          joined += chunk;
+        }
+        RC_ASSERT(joined == expected);
+        for (auto i = std::size_t{0}; i < expected.size(); i += 1 + expected.size() / 16) {
+          RC_ASSERT(rope[i] == expected[i]);
+        }
+        RC_ASSERT(rope == jtrope{std::string_view{expected}});
+        RC_ASSERT((rope == jtrope{std::string_view{expected + "!"}}) == false);
+
+        auto const str = rope.str();
+        RC_ASSERT(str == expected);
+        auto single = jtrope{jtstring{expected}};
+        RC_ASSERT(std::move(single).str() == expected);
+        RC_ASSERT(std::move(rope).str() == expected);
+      }
+    )
+
+  , rc::check
+    ( "operator==(s, s) one character differs"
+    , [&] {
+        auto const s1 = *strs;
+        auto s2 = s1;
+        auto const i = *rc::gen::inRange<std::size_t>(0, s2.size()).as("i");
+        s2[i] = static_cast<char>(s2[i] + 1);
+        auto const jtstr1 = jtstring{s1};
+        auto const jtstr2 = jtstring{s2};
+        RC_ASSERT(!(jtstr1 == jtstr2));
+        RC_ASSERT(!jtstr1.starts_with(jtstr2));
+      }
+    )
+
   , rc::check
     ( "operator==(s, sv)"
     , [&] {
@@ -827,6 +1634,376 @@ auto tests(rc::Gen<std::string> strs) -> bool {
       }
     )
 
+  , rc::check
+    ( "jtstring_pmr in arena"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto buffer = std::array<std::byte, 1 << 16>{};
+        auto arena = std::pmr::monotonic_buffer_resource{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+        auto const scope = jtstring_resource_scope{&arena};
+        auto jtstr = jtstring_pmr{s1};
+        jtstr.append(s2);
+        RC_ASSERT(jtstr == s1 + s2);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_pmr outlives scope"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto arena = std::pmr::monotonic_buffer_resource{};
+        auto jtstr = [&] {
+          auto const scope = jtstring_resource_scope{&arena};
+          return jtstring_pmr{s1};
+        }();
+        jtstr.append(s2);
+        RC_ASSERT(jtstr == s1 + s2);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_pool across resets"
+    , [&] {
+        auto const s1 = *strs + std::string(32, 'a');
+        auto const s2 = *strs;
+        auto pool = jtstring_pool{256};
+        auto other = jtstring_pool{256};
+        auto kept = jtstring{};
+        for (auto round = 0; round < 3; round += 1) {
+          {
+            auto const scope = jtstring_pool_scope{pool};
+            auto jtstr = jtstring_pooled{s1};
+            jtstr.append(s2).append(s1);
+            auto copy = jtstr;
+            copy.insert(copy.cbegin(), s2);
+            RC_ASSERT(jtstr == s1 + s2 + s1);
+            RC_ASSERT(copy == s2 + s1 + s2 + s1);
+            {
+              // A heap buffer grows within the pool it came from, which outlives the current one
+              auto const inner = jtstring_pool_scope{other};
+              jtstr.reserve(jtstr.capacity() + 1);
+              jtstr.append(s2);
+            }
+            other.reset();
+            {
+              auto const inner = jtstring_pool_scope{other};
+              auto const junk = jtstring_pooled{std::string(jtstr.size(), '#')};
+            }
+            RC_ASSERT(jtstr == s1 + s2 + s1 + s2);
+            // Only strings that opted in come from the pool
+            kept = jtstring{s2 + s1 + s2 + s1};
+          }
+          pool.reset();
+          RC_ASSERT(kept == s2 + s1 + s2 + s1);
+        }
+
+        // Without a current pool the buffers come from operator new
+        auto heap = jtstring_pooled{s1 + std::string(40, 'x')};
+        heap.append(s2);
+        RC_ASSERT(heap == s1 + std::string(40, 'x') + s2);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_malloc append(sv)"
+    , [&] {
+        auto s1 = *strs;
+        auto const s2 = *strs;
+        auto jtstr = jtstring_malloc{s1};
+        for (auto i = 0; i < 4; i += 1) {
+          s1.append(s2);
+          jtstr.append(s2);
+        }
+        RC_ASSERT(jtstr == s1);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_malloc append(self)"
+    , [&] {
+        auto s = *strs;
+        auto jtstr = jtstring_malloc{s};
+        for (auto i = 0; i < 4; i += 1) {
+          s.append(s);
+          jtstr.append(jtstr);
+        }
+        RC_ASSERT(jtstr == s);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_malloc insert(cpos, sv)"
+    , [&] {
+        auto s1 = *strs;
+        auto const i = *rc::gen::inRange<std::size_t>(0, s1.size());
+        auto const s2 = *strs;
+        auto jtstr = jtstring_malloc{s1};
+        jtstr.shrink_to_fit();
+        s1.insert(i, s2);
+        jtstr.insert(jtstr.begin() + i, s2);
+        RC_ASSERT(jtstr == s1);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_malloc push_back(ch)"
+    , [&] {
+        auto s = *strs;
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto jtstr = jtstring_malloc{s};
+        for (auto i = 0; i < 64; i += 1) {
+          s.push_back(ch);
+          jtstr.push_back(ch);
+        }
+        RC_ASSERT(jtstr == s);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_cached append(sv), copy"
+    , [&] {
+        auto s = *strs;
+        auto const s2 = *strs;
+        auto const limit = *rc::gen::inRange(0, 4);
+        jtstring_size_class_cache::set_limit(64, static_cast<std::size_t>(limit));
+        auto jtstr = jtstring_cached{s};
+        auto copies = std::vector<jtstring_cached>{};
+        for (auto i = 0; i < 8; i += 1) {
+          s.append(s2);
+          jtstr.append(s2);
+          copies.push_back(jtstr);
+        }
+        RC_ASSERT(jtstr == s);
+        copies.erase(copies.begin(), copies.begin() + 4);
+        copies.push_back(jtstring_cached{s2});
+        RC_ASSERT(copies.back() == s2);
+        jtstring_size_class_cache::set_limit(64, jtstring_size_class_cache::default_limit);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_cached thread_local constructed before the thread's cache"
+    , [&] {
+        auto const s = *strs;
+        auto result = std::string{};
+        std::thread{[&] {
+          // Constructed empty, so the cache's lists are only created by the first growth and destroyed before it
+          thread_local auto jtstr = jtstring_cached{};
+          jtstr.append(std::string(100, 'x'));
+          jtstr.append(s);
+          result = std::string{jtstr.view()};
+        }}.join();
+        RC_ASSERT(result == std::string(100, 'x') + s);
+        RC_ASSERT(jtstring_size_class_cache::limit(0) == 0);
+        RC_ASSERT(jtstring_size_class_cache::limit(jtstring_size_class_cache::max_size + 1) == 0);
+        jtstring_size_class_cache::set_limit(0, 1);
+        jtstring_size_class_cache::set_limit(jtstring_size_class_cache::max_size + 1, 1);
+        RC_ASSERT(jtstring_size_class_cache::limit(0) == 0);
+      }
+    )
+
+  , rc::check
+    ( "hash()"
+    , [&] {
+        auto const s = *strs;
+        auto const jtstr = jtstring{s};
+        auto large = jtstring{};
+        large.reserve(64);
+        large.append(s);
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+        RC_ASSERT(large.hash() == jtstr.hash());
+        RC_ASSERT(std::hash<jtstring>{}(jtstr) == jtstr.hash());
+      }
+    )
+
+  , rc::check
+    ( "hash() after erase"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto jtstr = jtstring{s1};
+        jtstr.append(s2);
+        jtstr.erase(s1.size());
+        RC_ASSERT(jtstr.hash() == jtstring{s1}.hash());
+      }
+    )
+
+  , rc::check
+    ( "hash() after modification"
+    , [&] {
+        auto s = *strs;
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        s.append(64, 'a');
+        auto jtstr = jtstring{s};
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+        jtstr[s.size() - 1] = ch;
+        s[s.size() - 1] = ch;
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+        *jtstr.begin() = ch;
+        s[0] = ch;
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+        jtstr.insert(jtstr.begin(), 1, ch);
+        s.insert(s.begin(), ch);
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+        jtstr.erase(0, 1);
+        s.erase(0, 1);
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+        jtstr.append(1, ch);
+        s.append(1, ch);
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+
+        // A pointer kept from before hash() has to be obtained again before writing through it
+        auto it = jtstr.data();
+        it[1] = ch;
+        s[1] = ch;
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+        it = jtstr.data();
+        it[2] = ch;
+        s[2] = ch;
+        RC_ASSERT(jtstr.hash() == jtstring_hash{}(std::string_view{s}));
+      }
+    )
+
+  , rc::check
+    ( "unordered_set find(sv)"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto const set = std::unordered_set<jtstring, jtstring_hash, std::equal_to<>>{jtstring{s1}};
+        RC_ASSERT(set.find(std::string_view{s1}) != set.end());
+        RC_ASSERT((set.find(std::string_view{s2}) != set.end()) == (s1 == s2));
+      }
+    )
+
+  , rc::check
+    ( "jtstring_shared copy then append(sv)"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto const original = jtstring_shared{s1};
+        auto copy = original;
+        RC_ASSERT(copy == original);
+        copy.append(s2);
+        RC_ASSERT(original == s1);
+        RC_ASSERT(copy == s1 + s2);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_shared copy then operator[]"
+    , [&] {
+        auto const s = *strs + std::string(32, 'a');
+        auto const i = *rc::gen::inRange<std::size_t>(0, s.size());
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto original = jtstring_shared{s};
+        auto copy = original;
+        RC_ASSERT(copy.c_str() == original.c_str());
+        copy[i] = ch;
+        auto expected = s;
+        expected[i] = ch;
+        RC_ASSERT(original == s);
+        RC_ASSERT(copy == expected);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_shared write through a pointer kept across a copy"
+    , [&] {
+        auto const s = *strs + std::string(40, 'a');
+        auto const i = *rc::gen::inRange<std::size_t>(0, s.size());
+        auto const ch = *rc::gen::arbitrary<char>().as("ch");
+        auto original = jtstring_shared{s};
+        original.append("b");
+        auto const shared = original;
+        RC_ASSERT(shared.c_str() == original.c_str());
+
+        auto const p = original.data();
+        auto copy = original;
+        RC_ASSERT(copy.c_str() != original.c_str());
+        p[i] = ch;
+        auto expected = s + "b";
+        RC_ASSERT(copy == expected);
+        RC_ASSERT(shared == expected);
+        expected[i] = ch;
+        RC_ASSERT(original == expected);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_shared copy then erase, insert"
+    , [&] {
+        auto s = *strs + std::string(32, 'a');
+        auto const i = *rc::gen::inRange<std::size_t>(0, s.size());
+        auto const s2 = *strs;
+        auto original = jtstring_shared{s};
+        auto copy = jtstring_shared{};
+        copy = original;
+        copy.erase(copy.begin() + i, copy.end());
+        RC_ASSERT(original == s);
+        RC_ASSERT(copy == s.substr(0, i));
+        copy = original;
+        copy.insert(copy.cbegin() + i, s2);
+        RC_ASSERT(original == s);
+        RC_ASSERT(copy == s.substr(0, i) + s2 + s.substr(i));
+      }
+    )
+
+  , rc::check
+    ( "adopt(buffer)"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto const capacity = s1.size() + *rc::gen::inRange<std::size_t>(0, 64);
+        auto buffer = std::make_unique<char[]>(capacity + 1);
+        std::copy(s1.begin(), s1.end(), buffer.get());
+        auto const data = buffer.get();
+        auto jtstr = jtstring{jtstring_buffer{std::move(buffer), s1.size(), capacity}};
+        RC_ASSERT(jtstr == s1);
+        RC_ASSERT(jtstr.capacity() > jtstring::inline_capacity || capacity <= jtstring::inline_capacity);
+        RC_ASSERT(jtstr.c_str() == data || capacity <= jtstring::inline_capacity);
+        jtstr.append(s2);
+        RC_ASSERT(jtstr == s1 + s2);
+      }
+    )
+
+  , rc::check
+    ( "jtstring_malloc adopt(buffer)"
+    , [&] {
+        auto const s1 = *strs;
+        auto const s2 = *strs;
+        auto buffer = std::make_unique<char[]>(s1.size() + 32);
+        std::copy(s1.begin(), s1.end(), buffer.get());
+        auto const data = buffer.get();
+        // Buffers from new[] are copied into the string's own allocator rather than adopted
+        auto jtstr = jtstring_malloc{jtstring_buffer{std::move(buffer), s1.size(), s1.size() + 31}};
+        RC_ASSERT(jtstr == s1);
+        RC_ASSERT(jtstr.c_str() != data);
+        for (auto i = 0; i < 4; i += 1) {
+          jtstr.append(s2);
+        }
+        RC_ASSERT(jtstr == s1 + s2 + s2 + s2 + s2);
+      }
+    )
+
+  , rc::check
+    ( "release()"
+    , [&] {
+        auto const s = *strs;
+        auto jtstr = jtstring{s};
+        auto const data = jtstr.c_str();
+        auto const large = jtstr.capacity() > jtstring::inline_capacity;
+        auto buffer = jtstr.release();
+        RC_ASSERT(std::string_view{buffer.data.get(), buffer.size} == s);
+        RC_ASSERT(buffer.data[buffer.size] == '\0');
+        RC_ASSERT(buffer.size <= buffer.capacity);
+        RC_ASSERT((buffer.data.get() == data) == large);
+        RC_ASSERT(jtstr.empty());
+        RC_ASSERT(jtstring{std::move(buffer)} == s);
+      }
+    )
+
   , rc::check
     ( "operator<<(os, s)"
     , [&] {